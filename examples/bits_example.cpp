@@ -0,0 +1,121 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// packs boolean arrays and compares with the output of np.packbits()
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    std::cerr << "error in line " << __LINE__ << std::endl;                    \
+    return false;                                                              \
+  }
+
+using cnpypp::BitOrder;
+
+static bool against_numpy() {
+  bool const bits[] = {1, 0, 1, 1, 0, 0, 0, 0, 1, 1};
+  size_t const n = std::size(bits);
+
+  // np.packbits(bits) and np.packbits(bits, bitorder='little')
+  std::vector<uint8_t> const big{0xb0, 0xc0}, little{0x0d, 0x03};
+
+  std::vector<uint8_t> packed(2, 0xff);
+  cnpypp::pack_bits(bits, n, packed.data(), BitOrder::Big);
+  CHECK(packed == big);
+  cnpypp::pack_bits(bits, n, packed.data(), BitOrder::Little);
+  CHECK(packed == little);
+
+  cnpypp::npy_save("bits.npy", bits, {n});
+
+  cnpypp::PackedBitArray const loaded = cnpypp::npy_load_packed("bits.npy");
+  CHECK(loaded.size == n && loaded.order == BitOrder::Big);
+  CHECK(std::equal(big.begin(), big.end(), loaded.bits().data()));
+
+  // count applies to bool arrays as well, like np.packbits(bits[:9])
+  {
+    cnpypp::PackedBitArray const head = cnpypp::npy_load_packed("bits.npy", 9);
+    CHECK(head.size == 9 && head.bytes.num_vals == 2);
+    CHECK(head.bits().data()[0] == 0xb0 && head.bits().data()[1] == 0x80);
+
+    bool threw = false;
+    try {
+      cnpypp::npy_load_packed("bits.npy", n + 1);
+    } catch (std::runtime_error const&) {
+      threw = true;
+    }
+    CHECK(threw);
+  }
+
+  // same file as np.save('packed.npy', np.packbits(bits))
+  cnpypp::npy_save_packed("packed.npy", loaded.bits());
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("packed.npy");
+    CHECK(arr.data_types.at(0) == 'u' && arr.word_sizes.at(0) == 1);
+    CHECK(arr.shape == std::vector<size_t>{2});
+    CHECK(std::equal(big.begin(), big.end(), arr.data<uint8_t>()));
+  }
+
+  // np.unpackbits(np.load('packed.npy'), count=n)
+  cnpypp::PackedBitArray const reloaded =
+      cnpypp::npy_load_packed("packed.npy", n);
+  cnpypp::bit_view const bv = reloaded.bits();
+  CHECK(bv.size() == n);
+  CHECK(std::equal(bits, bits + n, bv.begin()));
+  CHECK(bv.count() == 5 && bv.any() && !bv.all());
+
+  return true;
+}
+
+// large enough for the vectorized kernels, with a ragged tail
+static bool round_trip() {
+  size_t const n = 1000003;
+  std::unique_ptr<bool[]> bits{new bool[n]};
+  std::mt19937 rng{42};
+  std::generate_n(bits.get(), n, [&rng]() { return (rng() & 1) != 0; });
+  size_t const ones = std::count(bits.get(), bits.get() + n, true);
+
+  for (BitOrder order : {BitOrder::Big, BitOrder::Little}) {
+    std::vector<uint8_t> packed((n + 7) / 8);
+    cnpypp::pack_bits(bits.get(), n, packed.data(), order);
+
+    cnpypp::bit_view const bv{packed.data(), n, order};
+    CHECK(bv.count() == ones);
+    CHECK(std::equal(bits.get(), bits.get() + n, bv.begin()));
+
+    std::unique_ptr<bool[]> unpacked{new bool[n]};
+    cnpypp::unpack_bits(packed.data(), n, unpacked.get(), order);
+    CHECK(std::equal(bits.get(), bits.get() + n, unpacked.get()));
+
+    cnpypp::npy_save_unpacked("bits_large.npy", bv);
+    cnpypp::NpyArray const arr = cnpypp::npy_load("bits_large.npy");
+    CHECK(arr.data_types.at(0) == 'b' && arr.num_vals == n);
+    CHECK(std::equal(bits.get(), bits.get() + n, arr.data<bool>()));
+
+    cnpypp::PackedBitArray const loaded =
+        cnpypp::npy_load_packed("bits_large.npy", n, order);
+    CHECK(std::equal(packed.begin(), packed.end(), loaded.bits().data()));
+  }
+
+  return true;
+}
+
+int main() {
+  if (!against_numpy() || !round_trip()) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
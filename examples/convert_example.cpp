@@ -0,0 +1,163 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// compares the bulk conversion kernels (SIMD where the CPU supports it,
+// including AVX-512-FP16) and save_as<T> with element-wise conversions
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    std::cerr << "error in line " << __LINE__ << std::endl;                    \
+    return false;                                                              \
+  }
+
+using cnpypp::bfloat16;
+using cnpypp::float16;
+
+// random values of all magnitudes around the half-precision range plus
+// special values, rounding ties and subnormals
+static std::vector<double> test_values(size_t n) {
+  std::vector<double> values{0.0,
+                             -0.0,
+                             1.0,
+                             65504.0,
+                             65519.99,
+                             65520.0,
+                             1e6,
+                             6e-8,
+                             3e-8,
+                             1e-10,
+                             1.0 + 0x1p-11,
+                             1.0 + 0x1p-11 + 0x1p-40,
+                             1.0 + 0x1p-8 + 0x1p-40,
+                             std::numeric_limits<double>::infinity(),
+                             -std::numeric_limits<double>::infinity(),
+                             std::numeric_limits<double>::quiet_NaN()};
+
+  std::mt19937_64 rng{42};
+  std::uniform_real_distribution<double> mantissa{-2.0, 2.0};
+  std::uniform_int_distribution<int> exponent{-30, 20};
+  while (values.size() < n) {
+    values.push_back(std::ldexp(mantissa(rng), exponent(rng)));
+  }
+
+  return values;
+}
+
+template <typename T> static uint32_t bits_of(T value) {
+  if constexpr (std::is_same_v<T, float>) {
+    uint32_t b;
+    std::memcpy(&b, &value, sizeof(b));
+    return b;
+  } else {
+    return value.bits;
+  }
+}
+
+template <typename T> static bool is_nan(T value) {
+  return std::isnan(static_cast<float>(value));
+}
+
+// NaN payloads may differ between the kernels
+template <typename T> static bool same(T a, T b) {
+  return bits_of(a) == bits_of(b) || (is_nan(a) && is_nan(b));
+}
+
+// converts prefixes of src of several lengths with convert() and element-wise
+// with static_cast, so that the vector loops and their tails are covered
+template <typename TFrom, typename TTo>
+static bool agrees(std::vector<TFrom> const& src) {
+  for (size_t n : {size_t{0}, size_t{1}, size_t{7}, size_t{8}, size_t{15},
+                   size_t{17}, size_t{33}, src.size()}) {
+    std::vector<TTo> dst(n);
+    cnpypp::convert(src.data(), n, dst.data());
+
+    for (size_t i = 0; i < n; ++i) {
+      CHECK(same(dst[i], static_cast<TTo>(src[i])));
+    }
+  }
+
+  return true;
+}
+
+static bool kernels() {
+  std::vector<double> const d = test_values(1003);
+  std::vector<float> f(d.size());
+  cnpypp::convert(d.data(), d.size(), f.data());
+
+  std::vector<float16> h(d.size());
+  std::vector<bfloat16> b(d.size());
+  cnpypp::convert(f.data(), f.size(), h.data());
+  cnpypp::convert(f.data(), f.size(), b.data());
+
+  CHECK((agrees<double, float>(d)));
+  CHECK((agrees<float, float16>(f)));
+  CHECK((agrees<double, float16>(d)));
+  CHECK((agrees<float16, float>(h)));
+  CHECK((agrees<float, bfloat16>(f)));
+  CHECK((agrees<double, bfloat16>(d)));
+  CHECK((agrees<bfloat16, float>(b)));
+
+  return true;
+}
+
+static bool narrowing_save() {
+  // without NaN, so that the values can be compared
+  std::vector<double> d = test_values(5000);
+  d.erase(std::remove_if(d.begin(), d.end(),
+                         [](double v) { return std::isnan(v); }),
+          d.end());
+  size_t const n = d.size();
+
+  cnpypp::npy_save("narrow_f4.npy", d.begin(), {n}, cnpypp::save_as<float>);
+  cnpypp::npy_save("narrow_f2.npy", d.begin(), {n}, cnpypp::save_as<float16>);
+  cnpypp::npy_save("narrow_v2.npy", d.begin(), {n}, cnpypp::save_as<bfloat16>);
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("narrow_f4.npy");
+    CHECK(arr.data_types.at(0) == 'f' && arr.word_sizes.at(0) == 4);
+    for (size_t i = 0; i < n; ++i) {
+      CHECK(arr.data<float>()[i] == static_cast<float>(d[i]));
+    }
+  }
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("narrow_f2.npy");
+    CHECK(arr.data_types.at(0) == 'f' && arr.word_sizes.at(0) == 2);
+    for (size_t i = 0; i < n; ++i) {
+      CHECK(arr.data<float16>()[i].bits == float16(d[i]).bits);
+    }
+  }
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("narrow_v2.npy");
+    CHECK(arr.data_types.at(0) == 'V' && arr.word_sizes.at(0) == 2);
+    for (size_t i = 0; i < n; ++i) {
+      CHECK(arr.data<bfloat16>()[i].bits == bfloat16(d[i]).bits);
+    }
+  }
+
+  return true;
+}
+
+int main() {
+  if (!kernels() || !narrowing_save()) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -3,12 +3,70 @@
 // license available in LICENSE file, or at
 // http://www.opensource.org/licenses/mit-license.php
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <cnpy++.h>
 
+// saves doubles converted to float32 and float16 and checks the files,
+// returns 0 on mismatch
+static int check_save_as(void) {
+  double const data[] = {0.1, 1.5, -2.25, 65504.0};
+  uint16_t const half_bits[] = {0x2e66, 0x3e00, 0xc080, 0x7bff};
+  size_t const shape[] = {2, 2};
+  size_t rank = 0;
+
+  if (cnpypp_npy_save_as("float32_from_c.npy", cnpypp_float64, data, shape, 2,
+                         "w", cnpypp_memory_order_c, cnpypp_float32) != 0 ||
+      cnpypp_npy_save_as("float16_from_c.npy", cnpypp_float64, data, shape, 2,
+                         "w", cnpypp_memory_order_c, cnpypp_float16) != 0) {
+    return 0;
+  }
+
+  struct cnpypp_npyarray_handle* arr =
+      cnpypp_load_npyarray("float32_from_c.npy");
+  if (arr == NULL) {
+    return 0;
+  }
+  float const* const f = cnpypp_npyarray_get_data(arr);
+  size_t const* const loaded_shape = cnpypp_npyarray_get_shape(arr, &rank);
+  int ok = rank == 2 && loaded_shape[0] == 2 && loaded_shape[1] == 2;
+  for (size_t i = 0; i < 4; ++i) {
+    ok = ok && f[i] == (float)data[i];
+  }
+  cnpypp_free_npyarray(arr);
+
+  arr = cnpypp_load_npyarray("float16_from_c.npy");
+  if (arr == NULL) {
+    return 0;
+  }
+  uint16_t const* const h = cnpypp_npyarray_get_data(arr);
+  for (size_t i = 0; i < 4; ++i) {
+    ok = ok && h[i] == half_bits[i];
+  }
+  cnpypp_free_npyarray(arr);
+
+  // unknown source or target types are errors
+  enum cnpypp_data_type const unknown = (enum cnpypp_data_type)99;
+  ok = ok &&
+       cnpypp_npy_save_as("unknown.npy", unknown, data, shape, 2, "w",
+                          cnpypp_memory_order_c, cnpypp_float32) == -1 &&
+       cnpypp_npy_save_as("unknown.npy", cnpypp_float64, data, shape, 2, "w",
+                          cnpypp_memory_order_c, unknown) == -1;
+
+#ifndef NO_LIBZIP
+  ok = ok &&
+       cnpypp_npz_save_as("archive_as.npz", "f", cnpypp_float64, data, shape,
+                          2, "w", cnpypp_memory_order_c, cnpypp_float32) == 0 &&
+       cnpypp_npz_save_as("archive_as.npz", "u", cnpypp_float64, data, shape,
+                          2, "a", cnpypp_memory_order_c, unknown) == -1;
+#endif
+
+  return ok;
+}
+
 int main() {
   double const data[] = {1.2, 3.4, 5.6, 7.8};
   size_t const shape[] = {sizeof(data) / sizeof(data[0])};
@@ -26,5 +84,10 @@ int main() {
   cnpypp_npy_save_1d("string.npy", cnpypp_uint8, str, strlen(str), "w");
   cnpypp_npy_save_1d("string.npy", cnpypp_uint8, str2, strlen(str2), "a");
 
+  if (!check_save_as()) {
+    fprintf(stderr, "cnpypp_npy_save_as: unexpected result\n");
+    return EXIT_FAILURE;
+  }
+
   return EXIT_SUCCESS;
 }
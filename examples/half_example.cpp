@@ -0,0 +1,164 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// checks the rounding of float16 and bfloat16 against known bit patterns and
+// round-trips half-precision arrays
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    std::cerr << "error in line " << __LINE__ << std::endl;                    \
+    return false;                                                              \
+  }
+
+using cnpypp::bfloat16;
+using cnpypp::float16;
+
+namespace app {
+// 2 bytes of padding after a
+struct Padded {
+  int16_t a;
+  int32_t b;
+};
+CNPYPP_STRUCT(Padded, a, b)
+
+// the same layout, with a bfloat16 field in place of the padding
+struct WithBfloat {
+  int16_t a;
+  bfloat16 h;
+  int32_t b;
+};
+CNPYPP_STRUCT(WithBfloat, a, h, b)
+} // namespace app
+
+static bool rounding() {
+  CHECK(float16(1.0).bits == 0x3c00);
+  CHECK(float16(-2.0f).bits == 0xc000);
+  CHECK(float16(65504.0).bits == 0x7bff);
+  CHECK(float16(65520.0).bits == 0x7c00); // overflows to infinity
+  CHECK(float16(0x1p-24).bits == 0x0001); // smallest subnormal
+  CHECK(float16(0x1p-26).bits == 0x0000);
+  CHECK(float16(std::numeric_limits<float>::quiet_NaN()).bits > 0x7c00);
+
+  // ties to even
+  CHECK(float16(1.0 + 0x1p-11).bits == 0x3c00);
+  CHECK(float16(1.0 + 3 * 0x1p-11).bits == 0x3c02);
+  CHECK(bfloat16(1.0f + 0x1p-8f).bits == 0x3f80);
+  CHECK(bfloat16(1.0f + 3 * 0x1p-8f).bits == 0x3f82);
+
+  // Just above a tie, doubles round up. Going through float would round
+  // twice and hit the tie; round-to-odd in the intermediate float avoids it.
+  double const above_half_tie = 1.0 + 0x1p-11 + 0x1p-40;
+  CHECK(float16(static_cast<float>(above_half_tie)).bits == 0x3c00);
+  CHECK(float16(above_half_tie).bits == 0x3c01);
+
+  double const above_bfloat_tie = 1.0 + 0x1p-8 + 0x1p-40;
+  CHECK(bfloat16(static_cast<float>(above_bfloat_tie)).bits == 0x3f80);
+  CHECK(bfloat16(above_bfloat_tie).bits == 0x3f81);
+
+  // exact values convert back unchanged
+  CHECK(static_cast<float>(float16(0.1)) == 0x1.998p-4f);
+  CHECK(static_cast<float>(bfloat16(-3.5)) == -3.5f);
+
+  return true;
+}
+
+static bool round_trip() {
+  std::vector<float16> h;
+  std::vector<bfloat16> b;
+  for (int i = -50; i < 50; ++i) {
+    h.emplace_back(i * 0.37);
+    b.emplace_back(i * 1e3);
+  }
+
+  cnpypp::npy_save("float16.npy", h.begin(), {h.size()});
+  cnpypp::npy_save("bfloat16.npy", b.begin(), {b.size()});
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("float16.npy");
+    CHECK(arr.data_types.at(0) == 'f' && arr.word_sizes.at(0) == 2);
+    for (size_t i = 0; i < h.size(); ++i) {
+      CHECK(arr.data<float16>()[i].bits == h[i].bits);
+    }
+  }
+
+  cnpypp::NpyArray arr = cnpypp::npy_load("bfloat16.npy");
+  CHECK(arr.data_types.at(0) == 'V' && arr.word_sizes.at(0) == 2);
+
+  // 'V2' is dispatched as bfloat16 only on request
+  bool threw = false;
+  try {
+    cnpypp::visit(arr, [](auto s) { return s.size(); });
+  } catch (std::runtime_error const&) {
+    threw = true;
+  }
+  CHECK(threw);
+
+  auto const same = [](bfloat16 x, bfloat16 y) { return x.bits == y.bits; };
+  CHECK(cnpypp::visit<bfloat16>(arr, [&b, same](auto s) {
+    using T = typename decltype(s)::value_type;
+    if constexpr (std::is_same_v<T, bfloat16>) {
+      return std::equal(s.begin(), s.end(), b.begin(), same);
+    } else {
+      return false;
+    }
+  }));
+
+  // half-precision fields of structured arrays
+  std::vector<std::tuple<float16, bfloat16>> records;
+  for (size_t i = 0; i < h.size(); ++i) {
+    records.emplace_back(h[i], b[i]);
+  }
+  cnpypp::npy_save("half_records.npy", {"h", "b"}, records.begin(),
+                   {records.size()});
+
+  {
+    cnpypp::NpyArray const rec = cnpypp::npy_load("half_records.npy");
+    auto const column = rec.column_range<bfloat16>("b");
+    CHECK(std::equal(column.begin(), column.end(), b.begin(), same));
+  }
+
+  return true;
+}
+
+// unnamed padding has the same 'V2' descriptor as bfloat16 but must never
+// be taken for a bfloat16 field
+static bool padding() {
+  std::vector<app::Padded> const padded{{1, 2}, {3, 4}};
+  std::vector<app::WithBfloat> const with_bfloat{{1, bfloat16(0.5), 2}};
+
+  cnpypp::npy_save("padded.npy", padded.begin(), padded.end());
+  cnpypp::npy_save("with_bfloat.npy", with_bfloat.begin(), with_bfloat.end());
+
+  cnpypp::NpyArray const p = cnpypp::npy_load("padded.npy");
+  cnpypp::NpyArray const w = cnpypp::npy_load("with_bfloat.npy");
+  CHECK(p.word_sizes == w.word_sizes && p.data_types == w.data_types);
+
+  CHECK(p.matches_struct<app::Padded>());
+  CHECK(!p.matches_struct<app::WithBfloat>());
+  CHECK(w.matches_struct<app::WithBfloat>());
+  CHECK(!w.matches_struct<app::Padded>());
+
+  return true;
+}
+
+int main() {
+  if (!rounding() || !round_trip() || !padding()) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
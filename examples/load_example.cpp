@@ -0,0 +1,250 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// loads NPY data from memory buffers, non-seekable streams and pipes and
+// compares with the saved arrays
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <streambuf>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+#ifdef CNPYPP_POSIX
+#include <thread>
+
+#include <unistd.h>
+#endif
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    std::cerr << "error in line " << __LINE__ << std::endl;                    \
+    return false;                                                              \
+  }
+
+// returns true if f() throws std::runtime_error
+template <typename F> static bool throws(F&& f) {
+  try {
+    f();
+  } catch (std::runtime_error const&) {
+    return true;
+  }
+  return false;
+}
+
+static std::vector<std::byte> npy_image(std::vector<int64_t> const& data) {
+  std::vector<std::byte> image;
+  cnpypp::MemorySink sink{image};
+  cnpypp::npy_save(sink, data.begin(), {3, data.size() / 3});
+  return image;
+}
+
+static bool from_buffer() {
+  std::vector<int64_t> data(30);
+  std::iota(data.begin(), data.end(), -7);
+  std::vector<std::byte> const image = npy_image(data);
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load_from(image);
+    CHECK((arr.shape == std::vector<size_t>{3, 10}));
+    CHECK(arr.data_types.at(0) == 'i' && arr.word_sizes.at(0) == 8);
+    CHECK(std::equal(data.begin(), data.end(), arr.data<int64_t>()));
+
+    // no copy is made
+    CHECK(arr.data<std::byte>() + arr.num_bytes() ==
+          image.data() + image.size());
+  }
+
+  // the array owns the buffer
+  bool released = false;
+  {
+    auto owned = std::make_shared<std::vector<std::byte>>(image);
+    cnpypp::NpyArray const arr = cnpypp::npy_load_from(
+        *owned, [owned, &released]() mutable {
+          owned.reset();
+          released = true;
+        });
+    CHECK(!released);
+    CHECK(arr.data<int64_t>()[29] == data[29]);
+  }
+  CHECK(released);
+
+  // structured arrays
+  {
+    std::vector<std::tuple<int32_t, double>> const records{{1, 0.5}, {2, 1.5}};
+    cnpypp::npy_save("records.npy", {"i", "d"}, records.begin(),
+                     {records.size()});
+
+    std::ifstream fs{"records.npy", std::ios::binary};
+    std::vector<char> const bytes{std::istreambuf_iterator<char>{fs},
+                                  std::istreambuf_iterator<char>{}};
+    std::vector<std::byte> rec_image(bytes.size());
+    std::memcpy(rec_image.data(), bytes.data(), bytes.size());
+
+    cnpypp::NpyArray const arr = cnpypp::npy_load_from(rec_image);
+    auto const d = arr.column_range<double>("d");
+    CHECK((std::vector<double>(d.begin(), d.end()) ==
+           std::vector<double>{0.5, 1.5}));
+  }
+
+  return true;
+}
+
+// truncated or corrupt images are rejected instead of being read beyond the
+// end of the buffer
+static bool invalid_buffers() {
+  std::vector<std::byte> const image = npy_image(std::vector<int64_t>(30));
+  size_t const header_size = image.size() - 30 * sizeof(int64_t);
+
+  for (size_t size : {size_t{0}, size_t{6}, size_t{12}, header_size - 1,
+                      header_size, image.size() - 1}) {
+    cnpypp::span<std::byte const> const truncated{image.data(), size};
+    CHECK(throws([&]() { cnpypp::npy_load_from(truncated); }));
+  }
+
+  std::vector<std::byte> corrupt = image;
+  corrupt[1] = std::byte{'X'}; // magic string
+  CHECK(throws([&]() { cnpypp::npy_load_from(corrupt); }));
+
+  // trailing bytes are ignored
+  std::vector<std::byte> longer = image;
+  longer.resize(image.size() + 5);
+  CHECK(cnpypp::npy_load_from(longer).num_vals == 30);
+
+  return true;
+}
+
+// hands out the bytes in small pieces and cannot seek, like a pipe
+class TrickleBuffer : public std::streambuf {
+public:
+  TrickleBuffer(std::vector<std::byte> const& bytes)
+      : data(reinterpret_cast<char const*>(bytes.data()),
+             reinterpret_cast<char const*>(bytes.data()) + bytes.size()) {}
+
+protected:
+  virtual int_type underflow() override {
+    if (pos == data.size()) {
+      return traits_type::eof();
+    }
+    size_t const n = std::min<size_t>(7, data.size() - pos);
+    setg(&data[pos], &data[pos], &data[pos] + n);
+    pos += n;
+    return traits_type::to_int_type(*gptr());
+  }
+
+private:
+  std::string data;
+  size_t pos = 0;
+};
+
+static bool from_stream() {
+  std::vector<int64_t> first(30), second(60);
+  std::iota(first.begin(), first.end(), 0);
+  std::iota(second.begin(), second.end(), 100);
+
+  // two arrays back to back, as when they are sent over one connection
+  std::vector<std::byte> images = npy_image(first);
+  std::vector<std::byte> const image2 = npy_image(second);
+  images.insert(images.end(), image2.begin(), image2.end());
+
+  {
+    TrickleBuffer buf{images};
+    std::istream is{&buf};
+    CHECK(is.tellg() == -1); // not seekable
+
+    cnpypp::NpyArray const a = cnpypp::npy_load(is);
+    cnpypp::NpyArray const b = cnpypp::npy_load(is);
+    CHECK(std::equal(first.begin(), first.end(), a.data<int64_t>()));
+    CHECK((b.shape == std::vector<size_t>{3, 20}));
+    CHECK(std::equal(second.begin(), second.end(), b.data<int64_t>()));
+
+    CHECK(throws([&]() { cnpypp::npy_load(is); }));
+  }
+
+  // ends within the data
+  {
+    std::vector<std::byte> const truncated(image2.begin(), image2.end() - 1);
+    TrickleBuffer buf{truncated};
+    std::istream is{&buf};
+    CHECK(throws([&]() { cnpypp::npy_load(is); }));
+  }
+
+  return true;
+}
+
+#ifdef CNPYPP_POSIX
+// writes image to a pipe from another thread and reads it with npy_load_fd()
+static bool through_pipe(std::vector<std::byte> const& image,
+                         std::vector<int64_t> const& expected) {
+  int fds[2];
+  CHECK(pipe(fds) == 0);
+
+  std::thread writer{[&image, fd = fds[1]]() {
+    for (size_t done = 0; done < image.size();) {
+      ssize_t const n = write(fd, image.data() + done, image.size() - done);
+      if (n <= 0) {
+        break;
+      }
+      done += n;
+    }
+    close(fd);
+  }};
+
+  bool ok = false;
+  try {
+    cnpypp::NpyArray const arr = cnpypp::npy_load_fd(fds[0]);
+    ok = arr.num_vals == expected.size() &&
+         std::equal(expected.begin(), expected.end(), arr.data<int64_t>());
+  } catch (std::runtime_error const&) {
+  }
+
+  writer.join();
+  close(fds[0]);
+  return ok;
+}
+
+static bool from_fd() {
+  // larger than the pipe buffer
+  std::vector<int64_t> data(3 << 17);
+  std::iota(data.begin(), data.end(), 0);
+  std::vector<std::byte> const image = npy_image(data);
+  CHECK(through_pipe(image, data));
+
+  // ends within the header and within the data
+  for (size_t size : {size_t{9}, size_t{40}, image.size() - 8}) {
+    std::vector<std::byte> const truncated(image.begin(),
+                                           image.begin() + size);
+    CHECK(!through_pipe(truncated, data));
+  }
+
+  return true;
+}
+#endif
+
+int main() {
+  if (!from_buffer() || !invalid_buffers() || !from_stream()) {
+    return EXIT_FAILURE;
+  }
+
+#ifdef CNPYPP_POSIX
+  if (!from_fd()) {
+    return EXIT_FAILURE;
+  }
+#endif
+
+  return EXIT_SUCCESS;
+}
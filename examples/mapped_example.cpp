@@ -0,0 +1,159 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// computes arrays directly into memory-mapped files and reads them back,
+// also with access pattern hints
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    std::cerr << "error in line " << __LINE__ << std::endl;                    \
+    return false;                                                              \
+  }
+
+using cnpypp::MemoryOrder;
+
+static bool writable_mapping() {
+  // an existing, larger file is replaced
+  {
+    std::vector<double> const junk(100000, -1.0);
+    cnpypp::npy_save("mapped.npy", junk.begin(), {junk.size()});
+  }
+
+  {
+    cnpypp::NpyArray arr = cnpypp::npy_create_mapped<double>("mapped.npy",
+                                                             {100, 50});
+    CHECK(arr.num_vals == 5000 && arr.memory_order == MemoryOrder::C);
+    double* const d = arr.data<double>();
+    for (size_t i = 0; i < arr.num_vals; ++i) {
+      d[i] = 0.5 * i;
+    }
+    arr.sync();
+
+    // the file has its final size and content while still mapped
+    cnpypp::NpyArray const copy = cnpypp::npy_load("mapped.npy");
+    CHECK((copy.shape == std::vector<size_t>{100, 50}));
+    CHECK(copy.data<double>()[4999] == 0.5 * 4999);
+
+    d[0] = 42; // reaches the file when arr is destroyed
+  }
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("mapped.npy", true);
+    CHECK(arr.num_vals == 5000 && arr.data<double>()[0] == 42);
+    for (size_t i = 1; i < arr.num_vals; ++i) {
+      CHECK(arr.data<double>()[i] == 0.5 * i);
+    }
+
+    std::ifstream fs{"mapped.npy", std::ios::binary | std::ios::ate};
+    // header and data, nothing left of the previous content
+    CHECK(static_cast<size_t>(fs.tellg()) < 5000 * 8 + 256);
+  }
+
+  // Fortran order and the overload with a type descriptor
+  {
+    cnpypp::NpyArray arr =
+        cnpypp::npy_create_mapped("mapped_i2.npy", std::vector<size_t>{3, 4},
+                                  'i', 2, MemoryOrder::Fortran);
+    CHECK(arr.memory_order == MemoryOrder::Fortran);
+    auto m = arr.typed_view<int16_t, 2, cnpypp::layout_left>();
+    for (size_t i = 0; i < 3; ++i) {
+      for (size_t j = 0; j < 4; ++j) {
+        m(i, j) = static_cast<int16_t>(10 * i + j);
+      }
+    }
+  }
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("mapped_i2.npy");
+    CHECK(arr.data_types.at(0) == 'i' && arr.word_sizes.at(0) == 2);
+    CHECK(arr.memory_order == MemoryOrder::Fortran);
+    CHECK(arr.data<int16_t>()[1] == 10 && arr.data<int16_t>()[3] == 1);
+  }
+
+  // nothing to map
+  {
+    cnpypp::NpyArray const arr =
+        cnpypp::npy_create_mapped<float>("mapped_empty.npy", {0, 3});
+    CHECK(arr.num_vals == 0);
+  }
+  CHECK(cnpypp::npy_load("mapped_empty.npy").num_vals == 0);
+
+  return true;
+}
+
+using cnpypp::MapHint;
+
+static_assert(has_hint(MapHint::random | MapHint::populate, MapHint::random));
+static_assert(!has_hint(MapHint::sequential, MapHint::willneed));
+
+static bool map_hints() {
+  std::vector<int32_t> data(1 << 20);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<int32_t>(i * 7);
+  }
+  cnpypp::npy_save("hinted.npy", data.begin(), {data.size()});
+
+  // the hints do not change the content
+  for (MapHint hints :
+       {MapHint::none, MapHint::sequential, MapHint::random | MapHint::willneed,
+        MapHint::populate, MapHint::hugepages | MapHint::populate}) {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("hinted.npy", hints);
+    CHECK(std::equal(data.begin(), data.end(), arr.data<int32_t>()));
+  }
+
+  {
+    cnpypp::NpyArray arr = cnpypp::npy_load("hinted.npy", MapHint::random);
+    arr.prefetch();
+    arr.prefetch(4 * 1000 + 3, 100); // unaligned, widened to whole pages
+    arr.prefetch(arr.num_bytes() + 1);
+    arr.evict(arr.num_bytes() - 1, 1000);
+    CHECK(std::equal(data.begin(), data.end(), arr.data<int32_t>()));
+
+#ifdef CNPYPP_POSIX
+    // The mapping is private, so evicting discards modifications and the
+    // pages are read from the file again.
+    arr.data<int32_t>()[5] = -1;
+    arr.evict(0, 4);
+    CHECK(arr.data<int32_t>()[5] == data[5]);
+#endif
+  }
+
+  // arrays in memory are not affected
+  {
+    cnpypp::NpyArray arr = cnpypp::npy_load("hinted.npy");
+    arr.data<int32_t>()[5] = -1;
+    arr.evict();
+    CHECK(arr.data<int32_t>()[5] == -1);
+  }
+
+  // neither are writable mappings, which are shared with the file
+  {
+    cnpypp::NpyArray arr =
+        cnpypp::npy_create_mapped<int32_t>("hinted_w.npy", {data.size()});
+    std::copy(data.begin(), data.end(), arr.data<int32_t>());
+    arr.evict();
+    arr.prefetch();
+    CHECK(std::equal(data.begin(), data.end(), arr.data<int32_t>()));
+  }
+
+  return true;
+}
+
+int main() {
+  if (!writable_mapping() || !map_hints()) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,53 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// command-line driver for cnpypp::npy_relayout()
+//
+// usage: npy_relayout <input.npy> <output.npy> [C|F] [axis,axis,...] [MiB]
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cnpy++.hpp>
+
+int main(int argc, char** argv) {
+  if (argc < 3 || argc > 6) {
+    std::cerr << "usage: " << argv[0]
+              << " <input.npy> <output.npy> [C|F] [axis,axis,...] [MiB]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::string const order = (argc > 3) ? argv[3] : "C";
+  if (order != "C" && order != "F") {
+    std::cerr << "memory order must be either C or F" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<size_t> axes;
+  if (argc > 4) {
+    std::stringstream ss{argv[4]};
+    for (std::string axis; std::getline(ss, axis, ',');) {
+      axes.push_back(std::stoul(axis));
+    }
+  }
+
+  size_t const budget_mib = (argc > 5) ? std::stoul(argv[5]) : 1024;
+
+  try {
+    cnpypp::npy_relayout(
+        argv[1], argv[2], axes,
+        (order == "C") ? cnpypp::MemoryOrder::C : cnpypp::MemoryOrder::Fortran,
+        budget_mib << 20);
+  } catch (std::exception const& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
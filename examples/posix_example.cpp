@@ -0,0 +1,234 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// exercises the features that are only available on POSIX systems
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "cnpy++.hpp"
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    std::cerr << "error in line " << __LINE__ << std::endl;                    \
+    return false;                                                              \
+  }
+
+// several threads append rows (thread + 1, sequence number, row in block)
+// while another thread keeps loading the file: readers must only ever see
+// written rows, and in the end every row must be there exactly once
+static bool appender() {
+  unsigned constexpr num_threads = 8;
+  int64_t constexpr blocks_per_thread = 500;
+
+  std::atomic<bool> done{false};
+  std::atomic<bool> reader_ok{true};
+  size_t total_rows = 0;
+
+  {
+    auto app = cnpypp::npy_appender<int64_t>("appender.npy", {3});
+
+    CHECK(app.row_bytes() == 3 * sizeof(int64_t));
+    CHECK(app.append(nullptr, 0) == 0);
+
+    std::thread reader{[&]() {
+      while (!done.load()) {
+        cnpypp::NpyArray const arr = cnpypp::npy_load("appender.npy");
+        int64_t const* const data = arr.data<int64_t>();
+
+        // unwritten rows would be zero
+        if (!std::all_of(data, data + arr.num_vals,
+                         [](int64_t x) { return x != 0; })) {
+          reader_ok = false;
+        }
+      }
+    }};
+
+    std::vector<std::thread> writers;
+    std::vector<size_t> rows_written(num_threads);
+
+    for (unsigned t = 0; t < num_threads; ++t) {
+      writers.emplace_back([&app, &rows_written, t]() {
+        for (int64_t seq = 1; seq <= blocks_per_thread; ++seq) {
+          size_t const num_rows = 1 + seq % 4;
+          std::vector<int64_t> rows;
+
+          for (size_t k = 1; k <= num_rows; ++k) {
+            rows.insert(rows.end(), {static_cast<int64_t>(t) + 1, seq,
+                                     static_cast<int64_t>(k)});
+          }
+
+          app.append(cnpypp::span<int64_t const>{rows.data(), rows.size()});
+          rows_written[t] += num_rows;
+        }
+      });
+    }
+
+    for (auto& w : writers) {
+      w.join();
+    }
+
+    done = true;
+    reader.join();
+
+    for (size_t n : rows_written) {
+      total_rows += n;
+    }
+
+    // all append() calls have returned, so the header covers all rows
+    CHECK(cnpypp::npy_load("appender.npy").shape.at(0) == total_rows);
+    CHECK(app.commit() == total_rows);
+  }
+
+  CHECK(reader_ok);
+
+  cnpypp::NpyArray const arr = cnpypp::npy_load("appender.npy");
+  CHECK((arr.shape == std::vector<size_t>{total_rows, 3}));
+
+  // blocks are contiguous, each one appears exactly once
+  std::vector<std::vector<int>> seen(num_threads,
+                                     std::vector<int>(blocks_per_thread));
+  int64_t const* const data = arr.data<int64_t>();
+
+  for (size_t row = 0; row < total_rows;) {
+    int64_t const t = data[3 * row] - 1, seq = data[3 * row + 1];
+    size_t const num_rows = 1 + seq % 4;
+
+    CHECK(t >= 0 && t < static_cast<int64_t>(num_threads));
+    CHECK(seq >= 1 && seq <= blocks_per_thread);
+    CHECK(row + num_rows <= total_rows);
+
+    for (size_t k = 0; k < num_rows; ++k) {
+      CHECK(data[3 * (row + k)] == t + 1);
+      CHECK(data[3 * (row + k) + 1] == seq);
+      CHECK(data[3 * (row + k) + 2] == static_cast<int64_t>(k + 1));
+    }
+
+    ++seen[t][seq - 1];
+    row += num_rows;
+  }
+
+  for (auto const& s : seen) {
+    CHECK(std::all_of(s.begin(), s.end(), [](int n) { return n == 1; }));
+  }
+
+  return true;
+}
+
+// appends rows to a growable array until it has been remapped several
+// times; pointers obtained before stay valid, and the file ends up with
+// exactly the rows kept
+static bool growable() {
+  std::vector<size_t> header_and_rows;
+
+  {
+    auto arr = cnpypp::npy_create_growable<double>("growable.npy", {3});
+    double const* const first = arr.data<double>();
+    size_t n = 0;
+
+    for (size_t block = 0; block < 2000; ++block) {
+      std::vector<double> rows(3 * block);
+      for (auto& x : rows) {
+        x = static_cast<double>(n++);
+      }
+      arr.append(cnpypp::span<double const>{rows.data(), rows.size()});
+    }
+
+    CHECK(arr.data<double>() == first);
+    CHECK(arr.rows() * 3 == n);
+    CHECK(first[n - 1] == static_cast<double>(n - 1));
+
+    arr.sync();
+    {
+      cnpypp::NpyArray const loaded = cnpypp::npy_load("growable.npy");
+      CHECK((loaded.shape == std::vector<size_t>{n / 3, 3}));
+      CHECK(loaded.data<double>()[n - 1] == static_cast<double>(n - 1));
+    }
+
+    // new rows are zero-initialized
+    arr.resize(arr.rows() + 5);
+    CHECK(std::all_of(first + n, first + n + 15,
+                      [](double x) { return x == 0; }));
+
+    arr.resize(10);
+  }
+
+  cnpypp::NpyArray const loaded = cnpypp::npy_load("growable.npy");
+  CHECK((loaded.shape == std::vector<size_t>{10, 3}));
+  CHECK(loaded.data<double>()[29] == 29);
+
+  // the destructor has truncated the file to the header and 10 rows
+  std::ifstream fs{"growable.npy", std::ios::binary};
+  std::vector<size_t> word_sizes, shape;
+  std::vector<char> data_types;
+  std::vector<std::string> labels;
+  std::vector<std::vector<size_t>> field_shapes;
+  cnpypp::MemoryOrder memory_order;
+
+  cnpypp::parse_npy_header(fs, word_sizes, data_types, labels, field_shapes,
+                           shape, memory_order);
+  auto const data_offset = fs.tellg();
+  fs.seekg(0, std::ios::end);
+  CHECK(static_cast<size_t>(fs.tellg() - data_offset) == 30 * sizeof(double));
+
+  return true;
+}
+
+// replaces a shared-memory object by a smaller one while an array loaded
+// from the old one is still in use, which must keep its contents
+static bool shared_memory() {
+  std::string const name = "cnpypp_example_" + std::to_string(::getpid());
+
+  std::vector<int32_t> data(100000);
+  std::iota(data.begin(), data.end(), 1);
+  cnpypp::npy_save_shm(name, data.begin(), {100, 1000});
+
+  cnpypp::NpyArray const old = cnpypp::npy_load_shm(name);
+  CHECK((old.shape == std::vector<size_t>{100, 1000}));
+
+  {
+    auto arr = cnpypp::npy_create_shm<int32_t>(name, {10});
+    std::fill_n(arr.data<int32_t>(), 10, -1);
+  }
+
+  CHECK(std::equal(data.begin(), data.end(), old.data<int32_t>()));
+
+  {
+    cnpypp::NpyArray const replaced = cnpypp::npy_load_shm(name);
+    CHECK((replaced.shape == std::vector<size_t>{10}));
+    CHECK(std::all_of(replaced.data<int32_t>(), replaced.data<int32_t>() + 10,
+                      [](int32_t x) { return x == -1; }));
+  }
+
+  cnpypp::npy_remove_shm(name);
+
+  bool removed = false;
+  try {
+    cnpypp::npy_load_shm(name);
+  } catch (std::exception const&) {
+    removed = true;
+  }
+  CHECK(removed);
+
+  return true;
+}
+
+int main() {
+  if (!appender() || !growable() || !shared_memory()) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
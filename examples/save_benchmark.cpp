@@ -0,0 +1,90 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// compares the throughput of npy_save() and npy_save_parallel()
+//
+// usage: save_benchmark <output.npy> [GiB] [threads] [repetitions]
+//
+// Each timing includes an fsync() of the file, so that the numbers reflect
+// the storage device rather than the page cache.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cnpy++.hpp>
+
+static void sync_file(std::string const& fname) {
+  int const fd = ::open(fname.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    ::fsync(fd);
+    ::close(fd);
+  }
+}
+
+template <typename F>
+static double measure(std::string const& fname, unsigned repetitions, F f) {
+  double best = 0;
+
+  for (unsigned r = 0; r < repetitions; ++r) {
+    ::unlink(fname.c_str());
+    auto const start = std::chrono::steady_clock::now();
+    f();
+    sync_file(fname);
+    std::chrono::duration<double> const elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = (r == 0) ? elapsed.count() : std::min(best, elapsed.count());
+  }
+
+  return best;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2 || argc > 5) {
+    std::cerr << "usage: " << argv[0]
+              << " <output.npy> [GiB] [threads] [repetitions]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::string const fname = argv[1];
+  double const gib = (argc > 2) ? std::stod(argv[2]) : 4;
+  unsigned const threads = (argc > 3) ? std::stoul(argv[3]) : 0;
+  unsigned const repetitions = (argc > 4) ? std::stoul(argv[4]) : 3;
+
+  size_t const nels = static_cast<size_t>(gib * (1 << 30)) / sizeof(double);
+  std::vector<double> data(nels);
+  std::iota(data.begin(), data.end(), 0.);
+
+  size_t const shape[] = {nels};
+  double const mib = nels * sizeof(double) / double(1 << 20);
+
+  try {
+    double const t_serial = measure(fname, repetitions, [&]() {
+      cnpypp::npy_save(fname, data.data(), shape);
+    });
+    std::cout << "npy_save():          " << mib / t_serial << " MiB/s"
+              << std::endl;
+
+    double const t_parallel = measure(fname, repetitions, [&]() {
+      cnpypp::npy_save_parallel(fname, data.data(), shape,
+                                cnpypp::MemoryOrder::C, threads);
+    });
+    std::cout << "npy_save_parallel(): " << mib / t_parallel << " MiB/s"
+              << std::endl;
+  } catch (std::exception const& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ::unlink(fname.c_str());
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// writes arrays to the different sinks and compares with the files written
+// by npy_save()
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+#ifdef CNPYPP_POSIX
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <thread>
+
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    std::cerr << "error in line " << __LINE__ << std::endl;                    \
+    return false;                                                              \
+  }
+
+static std::vector<std::byte> read_file(std::string const& fname) {
+  std::ifstream fs{fname, std::ios::binary};
+  std::vector<char> const bytes{std::istreambuf_iterator<char>{fs},
+                                std::istreambuf_iterator<char>{}};
+  std::vector<std::byte> result(bytes.size());
+  std::memcpy(result.data(), bytes.data(), bytes.size());
+  return result;
+}
+
+// only overrides the single-buffer write(), so that header and payload
+// arrive separately
+class CountingSink : public cnpypp::Sink {
+public:
+  virtual void write(std::byte const* data, size_t size) override {
+    bytes.insert(bytes.end(), data, data + size);
+    ++calls;
+  }
+
+  std::vector<std::byte> bytes;
+  size_t calls = 0;
+};
+
+static bool portable_sinks() {
+  std::vector<double> data(1000);
+  std::iota(data.begin(), data.end(), 0.5);
+
+  cnpypp::npy_save("sink.npy", data.begin(), {10, 100});
+  std::vector<std::byte> const expected = read_file("sink.npy");
+
+  {
+    std::vector<std::byte> image{std::byte{42}};
+    cnpypp::MemorySink sink{image};
+    cnpypp::npy_save(sink, data.begin(), {10, 100});
+    CHECK(image.front() == std::byte{42}); // appended
+    CHECK(std::equal(image.begin() + 1, image.end(), expected.begin(),
+                     expected.end()));
+  }
+
+  {
+    std::vector<std::byte> chunks;
+    size_t calls = 0;
+    cnpypp::CallbackSink sink{[&](std::byte const* p, size_t n) {
+      chunks.insert(chunks.end(), p, p + n);
+      ++calls;
+    }};
+    cnpypp::npy_save(sink, data.begin(), {10, 100});
+    CHECK(chunks == expected && calls == 2);
+  }
+
+  // contiguous data go to the sink in one piece after the header
+  {
+    CountingSink sink;
+    cnpypp::npy_save(sink, data.begin(), {10, 100});
+    CHECK(sink.bytes == expected && sink.calls == 2);
+  }
+
+  // non-contiguous or converted data are written chunk-wise
+  {
+    std::list<double> const list(data.begin(), data.end());
+    CountingSink sink;
+    cnpypp::npy_save(sink, list.begin(), {10, 100});
+    CHECK(sink.bytes == expected);
+
+    cnpypp::npy_save("sink_f4.npy", data.begin(), {10, 100},
+                     cnpypp::save_as<float>);
+    CountingSink narrowed;
+    cnpypp::npy_save(narrowed, data.begin(), {10, 100},
+                     cnpypp::save_as<float>);
+    CHECK(narrowed.bytes == read_file("sink_f4.npy"));
+  }
+
+  return true;
+}
+
+#ifdef CNPYPP_POSIX
+static std::atomic<size_t> signals_received{0};
+
+static void on_signal(int) { ++signals_received; }
+
+static bool fd_sinks() {
+  std::vector<int32_t> data(4 << 20);
+  std::iota(data.begin(), data.end(), 0);
+
+  cnpypp::npy_save("sink_i4.npy", data.begin(), {data.size()});
+  std::vector<std::byte> const expected = read_file("sink_i4.npy");
+
+  {
+    cnpypp::FileDescriptorSink sink{"sink_fd.npy"};
+    cnpypp::npy_save(sink, data.begin(), {data.size()});
+  }
+  CHECK(read_file("sink_fd.npy") == expected);
+
+  // Writes to a pipe that the reader empties only slowly, while signals
+  // interrupt them. Without SA_RESTART, writev() then returns after writing
+  // part of the data (or fails with EINTR), which the sink has to resume.
+  struct sigaction action = {};
+  action.sa_handler = on_signal;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGUSR1, &action, nullptr);
+
+  int fds[2];
+  CHECK(pipe(fds) == 0);
+
+  std::vector<std::byte> received;
+  std::thread reader{[&received, fd = fds[0]]() {
+    std::byte buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+      received.insert(received.end(), buffer, buffer + n);
+      if (received.size() % (1 << 20) < sizeof(buffer)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+  }};
+
+  std::atomic<bool> done{false};
+  pthread_t const writer = pthread_self();
+  std::thread signaller{[&done, writer]() {
+    while (!done) {
+      pthread_kill(writer, SIGUSR1);
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }};
+
+  {
+    cnpypp::FileDescriptorSink sink{fds[1]};
+    cnpypp::npy_save(sink, data.begin(), {data.size()});
+  }
+
+  done = true;
+  signaller.join();
+  close(fds[1]);
+  reader.join();
+  close(fds[0]);
+
+  CHECK(signals_received > 0);
+  CHECK(received == expected);
+
+  return true;
+}
+#endif
+
+int main() {
+  if (!portable_sinks()) {
+    return EXIT_FAILURE;
+  }
+
+#ifdef CNPYPP_POSIX
+  if (!fd_sinks()) {
+    return EXIT_FAILURE;
+  }
+#endif
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// round-trips CSR and CSC matrices through .npz files laid out like the ones
+// of scipy.sparse.save_npz()
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    std::cerr << "error in line " << __LINE__ << std::endl;                    \
+    return false;                                                              \
+  }
+
+using cnpypp::SparseFormat;
+
+// [[1, 0, 2, 0],
+//  [0, 0, 0, 0],
+//  [0, 3, 0, 4]]
+static std::array<double, 12> const dense{1, 0, 2, 0, 0, 0, 0, 0, 0, 3, 0, 4};
+
+// expands the matrix into a row-major dense array
+template <typename TIndex>
+static std::vector<double> to_dense(cnpypp::SparseMatrix const& m) {
+  std::vector<double> result(m.shape[0] * m.shape[1]);
+  size_t const outer = m.format == SparseFormat::CSR ? m.shape[0] : m.shape[1];
+  auto const* const indptr = m.indptr.data<TIndex>();
+  auto const* const indices = m.indices.data<TIndex>();
+  auto const* const data = m.data.data<double>();
+
+  for (size_t i = 0; i < outer; ++i) {
+    for (auto k = indptr[i]; k < indptr[i + 1]; ++k) {
+      size_t const row = m.format == SparseFormat::CSR ? i : indices[k];
+      size_t const col = m.format == SparseFormat::CSR ? indices[k] : i;
+      result[row * m.shape[1] + col] = data[k];
+    }
+  }
+
+  return result;
+}
+
+static bool csr() {
+  std::vector<double> const data{1, 2, 3, 4};
+  std::vector<int32_t> const indices{0, 2, 1, 3}, indptr{0, 2, 2, 4};
+
+  for (bool compressed : {true, false}) {
+    cnpypp::save_sparse_npz<double, int32_t>(
+        "csr.npz", SparseFormat::CSR, {3, 4}, data, indices, indptr,
+        compressed);
+
+    // the members scipy.sparse.load_npz() expects
+    {
+      cnpypp::NpyArray const format = cnpypp::npz_load("csr.npz", "format");
+      CHECK(format.data_types.at(0) == 'S' && format.word_sizes.at(0) == 3);
+      CHECK(std::memcmp(format.data<char>(), "csr", 3) == 0);
+
+      cnpypp::NpyArray const shape = cnpypp::npz_load("csr.npz", "shape");
+      CHECK(shape.data_types.at(0) == 'i' && shape.word_sizes.at(0) == 8);
+      CHECK(shape.data<int64_t>()[0] == 3 && shape.data<int64_t>()[1] == 4);
+    }
+
+    // mapping is possible for uncompressed archives only, otherwise the
+    // arrays are read
+    for (bool mapped : {false, true}) {
+      cnpypp::SparseMatrix const m = cnpypp::load_sparse_npz("csr.npz", mapped);
+      CHECK(m.format == SparseFormat::CSR && m.nnz() == 4);
+      CHECK((m.shape == std::array<size_t, 2>{3, 4}));
+      CHECK(m.indices.word_sizes.at(0) == 4 && m.indptr.word_sizes.at(0) == 4);
+
+      auto const d = to_dense<int32_t>(m);
+      CHECK(std::equal(d.begin(), d.end(), dense.begin()));
+    }
+  }
+
+  return true;
+}
+
+static bool csc() {
+  // same matrix, column by column, with int64 indices
+  std::vector<double> const data{1, 3, 2, 4};
+  std::vector<int64_t> const indices{0, 2, 0, 2}, indptr{0, 1, 2, 3, 4};
+
+  cnpypp::save_sparse_npz<double, int64_t>("csc.npz", SparseFormat::CSC,
+                                           {3, 4}, data, indices, indptr);
+
+  {
+    cnpypp::SparseMatrix const m = cnpypp::load_sparse_npz("csc.npz");
+    CHECK(m.format == SparseFormat::CSC && m.nnz() == 4);
+    CHECK(m.indices.word_sizes.at(0) == 8);
+
+    // saving a loaded matrix again
+    cnpypp::save_sparse_npz("csc2.npz", m, false);
+  }
+
+  cnpypp::SparseMatrix const m = cnpypp::load_sparse_npz("csc2.npz", true);
+  auto const d = to_dense<int64_t>(m);
+  CHECK(std::equal(d.begin(), d.end(), dense.begin()));
+
+  // inconsistent index pointers are rejected
+  std::vector<int64_t> const short_indptr{0, 1, 2};
+  bool threw = false;
+  try {
+    cnpypp::save_sparse_npz<double, int64_t>(
+        "csc.npz", SparseFormat::CSC, {3, 4}, data, indices, short_indptr);
+  } catch (std::runtime_error const&) {
+    threw = true;
+  }
+  CHECK(threw);
+
+  return true;
+}
+
+int main() {
+  if (!csr() || !csc()) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,422 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// round-trips structs through structured arrays and checks the headers
+// against the dtype descriptions NumPy writes for the same layouts
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    std::cerr << "error in line " << __LINE__ << std::endl;                    \
+    return false;                                                              \
+  }
+
+namespace app {
+// no padding: stored as a plain list of fields
+struct Particle {
+  double x, y;
+  int32_t id;
+  float w;
+};
+CNPYPP_STRUCT(Particle, x, y, id, w)
+
+// padded like np.dtype([('id', '<i4'), ('v', '<f8'), ('flag', '?')],
+// align=True): 4 bytes after id, 7 after flag
+struct Sample {
+  int32_t id;
+  double v;
+  bool flag;
+};
+CNPYPP_STRUCT(Sample, id, v, flag)
+
+// std::array members become sub-array fields
+struct Body {
+  int32_t id;
+  std::array<double, 3> pos;
+};
+CNPYPP_STRUCT(Body, id, pos)
+
+struct Station {
+  cnpypp::fixed_string<5> code;
+  float elevation;
+};
+CNPYPP_STRUCT(Station, code, elevation)
+} // namespace app
+
+// the header dictionary of the .npy file fname
+static std::string header(std::string const& fname) {
+  std::ifstream fs{fname, std::ios::binary};
+  std::string const contents{std::istreambuf_iterator<char>{fs}, {}};
+  return contents.substr(10, contents.find('\n') - 10);
+}
+
+// writes a version 1.0 .npy file with the header dictionary dict
+static void write_npy(std::string const& fname, std::string dict,
+                      std::vector<char> const& data) {
+  while ((10 + dict.size() + 1) % 64 != 0) {
+    dict += ' ';
+  }
+  dict += '\n';
+
+  uint16_t const length = static_cast<uint16_t>(dict.size());
+  char const length_le[] = {static_cast<char>(length & 0xff),
+                            static_cast<char>(length >> 8)};
+
+  std::ofstream fs{fname, std::ios::binary};
+  fs.write("\x93NUMPY\x01\x00", 8);
+  fs.write(length_le, 2);
+  fs << dict;
+  fs.write(data.data(), data.size());
+}
+
+static bool contains(std::string const& str, std::string const& substr) {
+  return str.find(substr) != std::string::npos;
+}
+
+static bool aggregate_structs() {
+  std::vector<app::Particle> const particles{{1, 2, 3, 4}, {5, 6, 7, 8}};
+  cnpypp::npy_save("particles.npy", particles.begin(), particles.end());
+
+  // np.dtype([('x', '<f8'), ('y', '<f8'), ('id', '<i4'), ('w', '<f4')])
+  CHECK(contains(header("particles.npy"),
+                 "'descr': [('x', '<f8'), ('y', '<f8'), ('id', '<i4'), "
+                 "('w', '<f4')]"));
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("particles.npy");
+    CHECK(arr.matches_struct<app::Particle>());
+    CHECK(arr.total_value_size == sizeof(app::Particle));
+
+    auto const r = arr.struct_range<app::Particle>();
+    CHECK(r.size() == 2 && r[1].id == 7 && r[1].w == 8.0f && r[0].y == 2);
+
+    auto const ids = arr.column_range<int32_t>("id");
+    CHECK(*std::next(ids.begin()) == 7);
+  }
+
+  cnpypp::npy_save("particles.npy", particles.begin(), {2}, "a");
+
+  cnpypp::NpyArray const arr = cnpypp::npy_load("particles.npy");
+  CHECK(arr.shape.at(0) == 4);
+  CHECK(cnpypp::visit<app::Particle>(arr, [](auto r) {
+          return static_cast<size_t>(std::distance(r.begin(), r.end()));
+        }) == 4);
+
+  return true;
+}
+
+static bool padded_structs() {
+  static_assert(sizeof(app::Sample) == 24);
+
+  std::vector<app::Sample> const samples{{1, 2.5, true}, {3, 4.5, false}};
+  cnpypp::npy_save("samples.npy", samples.begin(), {2});
+
+  // the padding is described by unnamed void fields, as in dtype.descr
+  CHECK(contains(header("samples.npy"),
+                 "'descr': [('id', '<i4'), ('', '<V4'), ('v', '<f8'), "
+                 "('flag', '<b1'), ('', '<V7')]"));
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("samples.npy", true);
+    CHECK(arr.total_value_size == sizeof(app::Sample));
+    CHECK(arr.matches_struct<app::Sample>());
+    CHECK(!arr.matches_struct<app::Particle>());
+
+    // zero-copy access to the records
+    auto const r = arr.struct_range<app::Sample>();
+    CHECK(r[1].id == 3 && r[1].v == 4.5 && !r[1].flag && r[0].flag);
+    CHECK(*arr.column_range<double>("v").begin() == 2.5);
+  }
+
+  // the same records as written by np.save() with the aligned dtype, once
+  // with the descr list and once in the dict form with explicit offsets
+  std::vector<char> data(2 * sizeof(app::Sample));
+  std::memcpy(data.data(), samples.data(), data.size());
+
+  write_npy("samples_np.npy",
+            "{'descr': [('id', '<i4'), ('', '|V4'), ('v', '<f8'), "
+            "('flag', '|b1'), ('', '|V7')], 'fortran_order': False, "
+            "'shape': (2,), }",
+            data);
+  write_npy("samples_np_dict.npy",
+            "{'descr': {'names': ['id', 'v', 'flag'], 'formats': ['<i4', "
+            "'<f8', '|b1'], 'offsets': [0, 8, 16], 'itemsize': 24, "
+            "'aligned': True}, 'fortran_order': False, 'shape': (2,), }",
+            data);
+
+  for (char const* fname : {"samples_np.npy", "samples_np_dict.npy"}) {
+    cnpypp::NpyArray const arr = cnpypp::npy_load(fname);
+    CHECK(arr.matches_struct<app::Sample>());
+
+    auto const r = arr.struct_range<app::Sample>();
+    CHECK(r.size() == 2 && r[0].id == 1 && r[1].v == 4.5 && r[0].flag);
+  }
+
+  return true;
+}
+
+static bool subarray_fields() {
+  std::vector<app::Body> const bodies{{7, {1, 2, 3}}, {8, {4, 5, 6}}};
+  cnpypp::npy_save("bodies.npy", bodies.begin(), {2});
+
+  // np.dtype([('id', '<i4'), ('pos', '<f8', (3,))], align=True)
+  CHECK(contains(header("bodies.npy"),
+                 "'descr': [('id', '<i4'), ('', '<V4'), "
+                 "('pos', '<f8', (3,))]"));
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("bodies.npy");
+    CHECK((arr.field_shapes.at(2) == std::vector<size_t>{3}));
+    CHECK(arr.struct_range<app::Body>()[1].pos[2] == 6);
+
+    double sum = 0;
+    for (auto const pos : arr.column_range<double, 3>("pos")) {
+      sum += pos[0] + pos[1] + pos[2];
+    }
+    CHECK(sum == 21);
+  }
+
+  // np.zeros(1, dtype=[('m', '<f4', (2, 3)), ('k', 'u1')]), filled
+  std::vector<char> data(25);
+  float const m[6] = {1, 2, 3, 4, 5, 6};
+  std::memcpy(data.data(), m, sizeof(m));
+  data[24] = 9;
+
+  write_npy("subarray_np.npy",
+            "{'descr': [('m', '<f4', (2, 3)), ('k', '|u1')], "
+            "'fortran_order': False, 'shape': (1,), }",
+            data);
+
+  cnpypp::NpyArray const arr = cnpypp::npy_load("subarray_np.npy");
+  CHECK((arr.word_sizes == std::vector<size_t>{24, 1}));
+  CHECK((arr.field_shapes.at(0) == std::vector<size_t>{2, 3}));
+  CHECK((*arr.column_range<float, 6>("m").begin())[5] == 6);
+  CHECK(*arr.column_range<uint8_t>("k").begin() == 9);
+
+  // parse_npy_header() without field_shapes refuses sub-array fields
+  auto const parses_without_field_shapes = [](char const* fname) {
+    std::ifstream fs{fname, std::ios::binary};
+    std::vector<size_t> word_sizes, shape;
+    std::vector<char> data_types;
+    std::vector<std::string> labels;
+    cnpypp::MemoryOrder memory_order;
+
+    try {
+      cnpypp::parse_npy_header(fs, word_sizes, data_types, labels, shape,
+                               memory_order);
+    } catch (std::runtime_error const&) {
+      return false;
+    }
+    return true;
+  };
+  CHECK(parses_without_field_shapes("samples.npy"));
+  CHECK(!parses_without_field_shapes("subarray_np.npy"));
+
+  return true;
+}
+
+static bool strings() {
+  std::vector<std::string> const names{"ab", "", "cdefgh"};
+  cnpypp::npy_save("names.npy", names.begin(), {3},
+                   cnpypp::save_as<cnpypp::fixed_string<4>>);
+
+  // np.array([b'ab', b'', b'cdef'], dtype='S4')
+  CHECK(contains(header("names.npy"), "'descr': '|S4'"));
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("names.npy");
+    CHECK(std::memcmp(arr.data<char>(), "ab\0\0\0\0\0\0cdef", 12) == 0);
+
+    auto const r = arr.string_range<char>();
+    std::vector<std::string_view> const views(r.begin(), r.end());
+    CHECK((views == std::vector<std::string_view>{"ab", "", "cdef"}));
+  }
+
+  std::vector<std::u32string> const words{U"\u00e4\u00f6", U"xyzzy"};
+  cnpypp::npy_save("words.npy", words.begin(), {2},
+                   cnpypp::save_as<cnpypp::fixed_u32string<3>>);
+
+  // np.array(['\u00e4\u00f6', 'xyz'], dtype='<U3')
+  CHECK(contains(header("words.npy"), "'descr': '<U3'"));
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("words.npy");
+    auto const r = arr.string_range<char32_t>();
+    std::vector<std::u32string_view> const views(r.begin(), r.end());
+    CHECK((views ==
+           std::vector<std::u32string_view>{U"\u00e4\u00f6", U"xyz"}));
+  }
+
+  std::vector<app::Station> const stations{{"ZUG", 2962.f},
+                                           {"MONTE", 4634.f}};
+  cnpypp::npy_save("stations.npy", stations.begin(), {2});
+
+  // np.dtype([('code', 'S5'), ('elevation', '<f4')], align=True)
+  CHECK(contains(header("stations.npy"), "'descr': [('code', '|S5'), "
+                                         "('', '<V3'), ('elevation', '<f4')]"));
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("stations.npy");
+    auto const codes = arr.string_column_range<char>("code");
+    CHECK(*std::next(codes.begin()) == "MONTE");
+    CHECK(arr.struct_range<app::Station>()[0].code.view() == "ZUG");
+  }
+
+  return true;
+}
+
+static bool column_projection() {
+  using record = std::tuple<int32_t, double, std::array<float, 3>, int16_t>;
+  size_t const n = 1000;
+
+  std::vector<record> records(n);
+  for (size_t i = 0; i < n; ++i) {
+    float const f = static_cast<float>(i);
+    records[i] = record{static_cast<int32_t>(i), 0.5 * i, {f, f + 1, f + 2},
+                        static_cast<int16_t>(i % 100)};
+  }
+  cnpypp::npy_save("records.npy", {"a", "b", "c", "d"}, records.begin(),
+                   {n / 4, 4});
+
+  // np.load('records.npy')[['d', 'a']], but packed and in the given order
+  {
+    cnpypp::NpyArray const arr =
+        cnpypp::npy_load_columns("records.npy", {"d", "a"});
+    CHECK((arr.labels == std::vector<std::string>{"d", "a"}));
+    CHECK((arr.shape == std::vector<size_t>{n / 4, 4}));
+    CHECK(arr.total_value_size == sizeof(int16_t) + sizeof(int32_t));
+
+    size_t i = 0;
+    for (auto const [d, a] : arr.tuple_range<int16_t, int32_t>()) {
+      CHECK(d == std::get<3>(records[i]) && a == std::get<0>(records[i]));
+      ++i;
+    }
+    CHECK(i == n);
+  }
+
+  // adjacent fields including a sub-array
+  {
+    cnpypp::NpyArray const arr =
+        cnpypp::npy_load_columns("records.npy", {"b", "c"});
+    CHECK((arr.field_shapes.at(1) == std::vector<size_t>{3}));
+
+    size_t i = 0;
+    for (auto const c : arr.column_range<float, 3>("c")) {
+      CHECK(c[2] == std::get<2>(records[i])[2]);
+      ++i;
+    }
+    CHECK(i == n);
+  }
+
+  // a single field yields a plain array, like np.load(...)['b']
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load_columns("records.npy", {"b"});
+    CHECK(arr.labels.empty() && arr.data_types.at(0) == 'f');
+    CHECK(arr.data<double>()[n - 1] == 0.5 * (n - 1));
+  }
+
+  bool threw = false;
+  try {
+    cnpypp::npy_load_columns("records.npy", {"x"});
+  } catch (std::runtime_error const&) {
+    threw = true;
+  }
+  CHECK(threw);
+
+  return true;
+}
+
+static bool scans() {
+  using record = std::tuple<int64_t, uint8_t, float, double>;
+  size_t const n = 100003;
+
+  std::vector<record> records(n);
+  for (size_t i = 0; i < n; ++i) {
+    int64_t const k = static_cast<int64_t>(i * 7919 % 1000) - 500;
+    records[i] = record{k * 1000000007, static_cast<uint8_t>(i % 256),
+                        k * 0.25f, std::sin(0.001 * i)};
+  }
+  cnpypp::npy_save("scan.npy", {"id", "tag", "x", "y"}, records.begin(), {n});
+  cnpypp::NpyArray const arr = cnpypp::npy_load("scan.npy");
+
+  using cnpypp::column;
+
+  // operands keep their type: 2.5 is not truncated for the integer field,
+  // -1 compares below all unsigned tags
+  std::vector<std::vector<cnpypp::ScanPredicate>> const queries{
+      {column("id") > 2.5},
+      {column("tag").between(10, 20), column("x") < 0},
+      {column("tag") > -1, column("y") >= 0.5},
+      {column("tag").in({1, 3, 300}), column("id") != 0},
+      {column("x").between(-10.1, 10.1), column("y") < 0}};
+
+  std::vector<std::function<bool(record const&)>> const expected{
+      [](record const& r) { return std::get<0>(r) > 2; },
+      [](record const& r) {
+        return std::get<1>(r) >= 10 && std::get<1>(r) <= 20 &&
+               std::get<2>(r) < 0;
+      },
+      [](record const& r) { return std::get<3>(r) >= 0.5; },
+      [](record const& r) {
+        return (std::get<1>(r) == 1 || std::get<1>(r) == 3) &&
+               std::get<0>(r) != 0;
+      },
+      [](record const& r) {
+        return std::get<2>(r) >= -10.1 && std::get<2>(r) <= 10.1 &&
+               std::get<3>(r) < 0;
+      }};
+
+  for (size_t q = 0; q < queries.size(); ++q) {
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < n; ++i) {
+      if (expected[q](records[i])) {
+        indices.push_back(i);
+      }
+    }
+
+    cnpypp::PackedBitArray const bitmap = cnpypp::scan(arr, queries[q]);
+    cnpypp::bit_view const bits = bitmap.bits();
+    CHECK(bits.size() == n && bits.count() == indices.size());
+    CHECK(std::all_of(indices.begin(), indices.end(),
+                      [&bits](size_t i) { return bits[i]; }));
+
+    CHECK(cnpypp::scan_indices(arr, queries[q], 3) == indices);
+
+    cnpypp::NpyArray const selected = cnpypp::scan_select(arr, queries[q]);
+    CHECK(selected.shape == std::vector<size_t>{indices.size()});
+    CHECK(selected.labels == arr.labels);
+
+    auto const r = selected.tuple_range<int64_t, uint8_t, float, double>();
+    CHECK(std::equal(r.begin(), r.end(), indices.begin(), indices.end(),
+                     [&records](auto const& a, size_t i) {
+                       return a == records[i];
+                     }));
+  }
+
+  return true;
+}
+
+int main() {
+  if (!aggregate_structs() || !padded_structs() || !subarray_fields() ||
+      !strings() || !column_projection() || !scans()) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
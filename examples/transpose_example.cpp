@@ -0,0 +1,116 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// saves and loads arrays in the respective other memory order and compares
+// against index arithmetic
+
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    std::cerr << "error in line " << __LINE__ << std::endl;                    \
+    return false;                                                              \
+  }
+
+using cnpypp::MemoryOrder;
+
+// the Fortran-order copy of the C-order array a of shape (n0, n1, n2)
+template <typename T>
+static std::vector<T> to_fortran(std::vector<T> const& a, size_t n0, size_t n1,
+                                 size_t n2) {
+  std::vector<T> f(a.size());
+  for (size_t i = 0; i < n0; ++i) {
+    for (size_t j = 0; j < n1; ++j) {
+      for (size_t k = 0; k < n2; ++k) {
+        f[i + n0 * (j + n1 * k)] = a[(i * n1 + j) * n2 + k];
+      }
+    }
+  }
+  return f;
+}
+
+// saves C-order data as Fortran-order file and vice versa, then loads them
+// in both memory orders
+template <typename T> static bool round_trip(size_t n0, size_t n1, size_t n2) {
+  std::vector<T> c(n0 * n1 * n2);
+  for (size_t i = 0; i < c.size(); ++i) {
+    c[i] = static_cast<T>(i % 251);
+  }
+  std::vector<T> const f = to_fortran(c, n0, n1, n2);
+  size_t const shape[] = {n0, n1, n2};
+
+  cnpypp::npy_save("transposed_f.npy", c.data(), shape, "w", MemoryOrder::C,
+                   MemoryOrder::Fortran);
+  cnpypp::npy_save("transposed_c.npy", f.data(), shape, "w",
+                   MemoryOrder::Fortran, MemoryOrder::C);
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("transposed_f.npy");
+    CHECK(arr.memory_order == MemoryOrder::Fortran);
+    CHECK(std::equal(f.begin(), f.end(), arr.data<T>()));
+  }
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("transposed_c.npy");
+    CHECK(arr.memory_order == MemoryOrder::C);
+    CHECK(std::equal(c.begin(), c.end(), arr.data<T>()));
+  }
+
+  for (MemoryOrder desired : {MemoryOrder::C, MemoryOrder::Fortran}) {
+    auto const& expected = desired == MemoryOrder::C ? c : f;
+    for (char const* fname : {"transposed_f.npy", "transposed_c.npy"}) {
+      cnpypp::NpyArray const arr = cnpypp::npy_load(fname, desired);
+      CHECK(arr.memory_order == desired);
+      CHECK(std::equal(expected.begin(), expected.end(), arr.data<T>()));
+    }
+  }
+
+  return true;
+}
+
+// element sizes without a specialized kernel
+static bool odd_element_size() {
+  size_t const shape[] = {37, 41};
+  size_t const esize = 3;
+  std::vector<std::byte> src(shape[0] * shape[1] * esize);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = std::byte(i % 253);
+  }
+
+  std::vector<std::byte> dst(src.size()), back(src.size());
+  cnpypp::transpose_memory_order(src.data(), dst.data(), shape, esize,
+                                 MemoryOrder::C);
+  cnpypp::transpose_memory_order(dst.data(), back.data(), shape, esize,
+                                 MemoryOrder::Fortran);
+  CHECK(back == src);
+
+  // element (i, j) of the Fortran-order result
+  size_t const i = 5, j = 17;
+  CHECK(std::equal(dst.begin() + (i + shape[0] * j) * esize,
+                   dst.begin() + (i + shape[0] * j + 1) * esize,
+                   src.begin() + (i * shape[1] + j) * esize));
+
+  return true;
+}
+
+int main() {
+  // ragged tile edges, and an array that is written in several slabs
+  if (!round_trip<uint8_t>(33, 65, 7) || !round_trip<int16_t>(5, 1, 3) ||
+      !round_trip<float>(64, 31, 2) ||
+      !round_trip<std::complex<double>>(3, 100, 9) ||
+      !round_trip<double>(7, 401, 800) || !odd_element_size()) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// slices arrays with NpyArrayView and accesses them with typed_view(),
+// comparing against index arithmetic
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    std::cerr << "error in line " << __LINE__ << std::endl;                    \
+    return false;                                                              \
+  }
+
+namespace app {
+struct Point {
+  float x, y;
+};
+CNPYPP_STRUCT(Point, x, y)
+} // namespace app
+
+// returns true if f() throws std::runtime_error
+template <typename F> static bool throws(F&& f) {
+  try {
+    f();
+  } catch (std::runtime_error const&) {
+    return true;
+  }
+  return false;
+}
+
+static bool slicing() {
+  std::vector<int> data(4 * 5 * 6);
+  std::iota(data.begin(), data.end(), 0);
+  cnpypp::npy_save("view.npy", data.data(), {4, 5, 6});
+
+  // the view shares ownership of the data and outlives the array
+  cnpypp::NpyArrayView const view = cnpypp::npy_load("view.npy").view();
+  CHECK(view.is_contiguous());
+  CHECK(view.at<int>({3, 4, 5}) == 119);
+
+  // a[2]
+  auto const row = view.row(2);
+  CHECK(row.rank() == 2 && row.is_contiguous());
+  CHECK(row.at<int>({1, 2}) == 2 * 30 + 1 * 6 + 2);
+  {
+    auto const r = row.make_range<int>();
+    CHECK(std::equal(r.begin(), r.end(), data.begin() + 60));
+  }
+
+  // a[1, :, 3], a strided range
+  {
+    auto const column = view.select(2, 3).select(0, 1);
+    auto const r = column.make_range<int>();
+    std::vector<int> const values(r.begin(), r.end());
+    CHECK((values == std::vector<int>{33, 39, 45, 51, 57}));
+  }
+
+  // a[:, 1:5:2]
+  {
+    auto const sliced = view.slice(1, 1, 5, 2);
+    CHECK((sliced.shape() == std::vector<size_t>{4, 2, 6}));
+    CHECK(sliced.at<int>({0, 1, 0}) == 18);
+  }
+
+  // a.T and np.transpose(a, (1, 0, 2))
+  {
+    auto const t = view.transpose();
+    CHECK(t.at<int>({5, 4, 3}) == 119);
+    CHECK(!t.is_contiguous());
+    CHECK(t.is_contiguous(cnpypp::MemoryOrder::Fortran));
+
+    size_t const axes[] = {1, 0, 2};
+    CHECK(view.transpose(axes).at<int>({4, 3, 5}) == 119);
+  }
+
+  bool threw = false;
+  try {
+    view.at<int>({4, 0, 0});
+  } catch (std::out_of_range const&) {
+    threw = true;
+  }
+  CHECK(threw);
+
+  // views can be handed to other threads
+  bool thread_ok = false;
+  std::thread{[row, &thread_ok]() {
+    thread_ok = row.at<int>({0, 0}) == 60;
+  }}.join();
+  CHECK(thread_ok);
+
+  return true;
+}
+
+static bool fortran_and_structured() {
+  std::vector<double> data(6);
+  std::iota(data.begin(), data.end(), 0.0);
+  cnpypp::npy_save("view_f.npy", data.data(), {2, 3}, "w",
+                   cnpypp::MemoryOrder::Fortran);
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("view_f.npy");
+    auto const view = arr.view();
+    CHECK(view.at<double>({1, 2}) == 5 && view.at<double>({1, 0}) == 1);
+
+    auto const r = view.row(1).make_range<double>();
+    CHECK((std::vector<double>(r.begin(), r.end()) ==
+           std::vector<double>{1, 3, 5}));
+  }
+
+  std::vector<std::tuple<int, double>> const records{
+      {1, 1.5}, {2, 2.5}, {3, 3.5}};
+  cnpypp::npy_save("view_s.npy", {"i", "d"}, records.begin(), {3});
+
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("view_s.npy");
+    auto const d = arr.view().slice(0, 1, 3).column_range<double>("d");
+    CHECK((std::vector<double>(d.begin(), d.end()) ==
+           std::vector<double>{2.5, 3.5}));
+  }
+
+  return true;
+}
+
+static bool typed_views() {
+  std::vector<int32_t> data(4 * 5 * 6);
+  std::iota(data.begin(), data.end(), 0);
+  cnpypp::npy_save("typed.npy", data.data(), {4, 5, 6});
+
+  {
+    cnpypp::NpyArray arr = cnpypp::npy_load("typed.npy");
+    auto const m = arr.typed_view<int32_t, 3>();
+    CHECK(m.extent(0) == 4 && m.extent(1) == 5 && m.extent(2) == 6);
+    CHECK(m.stride(0) == 30 && m.stride(1) == 6 && m.stride(2) == 1);
+    CHECK(m.size() == data.size() && m.data_handle() == arr.data<int32_t>());
+
+    for (size_t i = 0; i < 4; ++i) {
+      for (size_t j = 0; j < 5; ++j) {
+        for (size_t k = 0; k < 6; ++k) {
+          CHECK(m(i, j, k) == static_cast<int32_t>((i * 5 + j) * 6 + k));
+        }
+      }
+    }
+    CHECK((m[std::array<size_t, 3>{3, 4, 5}] == 119));
+
+    // writes go to the array
+    m(1, 2, 3) = -1;
+    CHECK(arr.data<int32_t>()[(1 * 5 + 2) * 6 + 3] == -1);
+
+    cnpypp::NpyArray const& carr = arr;
+    CHECK((carr.typed_view<int32_t, 3>()(1, 2, 3) == -1));
+
+    // type, rank and memory order are checked
+    using cnpypp::layout_left;
+    CHECK(throws([&]() { arr.typed_view<float, 3>(); }));
+    CHECK(throws([&]() { arr.typed_view<int32_t, 2>(); }));
+    CHECK(throws([&]() { arr.typed_view<int32_t, 3, layout_left>(); }));
+  }
+
+  // Fortran order: the first index varies fastest
+  std::vector<double> f(6);
+  std::iota(f.begin(), f.end(), 0.0);
+  cnpypp::npy_save("typed_f.npy", f.data(), {2, 3}, "w",
+                   cnpypp::MemoryOrder::Fortran);
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("typed_f.npy", true);
+    auto const m = arr.typed_view<double, 2, cnpypp::layout_left>();
+    CHECK(m.stride(0) == 1 && m.stride(1) == 2);
+    CHECK(m(1, 0) == 1 && m(0, 2) == 4 && m(1, 2) == 5);
+    CHECK(throws([&]() { arr.typed_view<double, 2>(); }));
+  }
+
+  // registered structs as element type
+  std::vector<app::Point> const points{{1, 2}, {3, 4}, {5, 6}, {7, 8}};
+  cnpypp::npy_save("typed_s.npy", points.begin(), points.end());
+  {
+    cnpypp::NpyArray const arr = cnpypp::npy_load("typed_s.npy");
+    auto const m = arr.typed_view<app::Point, 1>();
+    CHECK(m.extent(0) == 4 && m(2).x == 5 && m(3).y == 8);
+  }
+
+  return true;
+}
+
+int main() {
+  if (!slicing() || !fortran_and_structured() || !typed_views()) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
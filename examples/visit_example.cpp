@@ -0,0 +1,136 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+// dispatches arrays of all supported element types with visit() and checks
+// that the kernel is instantiated for the stored type
+
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    std::cerr << "error in line " << __LINE__ << std::endl;                    \
+    return false;                                                              \
+  }
+
+using cnpypp::float16;
+
+// returns true if f() throws std::runtime_error
+template <typename F> static bool throws(F&& f) {
+  try {
+    f();
+  } catch (std::runtime_error const&) {
+    return true;
+  }
+  return false;
+}
+
+template <typename T> static double to_double(T value) {
+  return static_cast<double>(value);
+}
+
+template <typename T> static double to_double(std::complex<T> value) {
+  return static_cast<double>(value.real());
+}
+
+// saves {1, 2, 3, 4} as T (all true for bool) and visits the loaded array
+template <typename T> static bool dispatches() {
+  std::vector<T> const values{T(1), T(2), T(3), T(4)};
+  double const expected = std::is_same_v<T, bool> ? 4 : 10;
+  cnpypp::npy_save("visit.npy", values.begin(), {2, 2});
+  cnpypp::NpyArray arr = cnpypp::npy_load("visit.npy");
+
+  // f is instantiated for all types, only the one for T is called
+  auto const sum = [](auto s) {
+    using value_type = std::remove_const_t<typename decltype(s)::value_type>;
+    double result = std::is_same_v<value_type, T> ? 0 : -1000;
+    for (auto const& v : s) {
+      result += to_double(v);
+    }
+    return result;
+  };
+  CHECK(cnpypp::visit(arr, sum) == expected);
+
+  cnpypp::NpyArray const& carr = arr;
+  CHECK(cnpypp::visit(carr, sum) == expected);
+
+  // the span refers to the array's data
+  cnpypp::visit(arr, [](auto s) {
+    if constexpr (!std::is_same_v<typename decltype(s)::value_type, bool>) {
+      s[3] = s[0];
+    }
+  });
+  if constexpr (!std::is_same_v<T, bool>) {
+    CHECK(to_double(arr.data<T>()[3]) == 1);
+  }
+
+  return true;
+}
+
+static bool scalar_types() {
+  return dispatches<bool>() && dispatches<int8_t>() && dispatches<uint8_t>() &&
+         dispatches<int16_t>() && dispatches<uint16_t>() &&
+         dispatches<int32_t>() && dispatches<uint32_t>() &&
+         dispatches<int64_t>() && dispatches<uint64_t>() &&
+         dispatches<float16>() && dispatches<float>() &&
+         dispatches<double>() && dispatches<long double>() &&
+         dispatches<std::complex<float>>() &&
+         dispatches<std::complex<double>>();
+}
+
+static bool structured_and_unsupported() {
+  std::vector<std::tuple<int32_t, double>> const records{{1, 0.5}, {2, 1.5}};
+  cnpypp::npy_save("visit_s.npy", {"i", "d"}, records.begin(),
+                   {records.size()});
+  cnpypp::NpyArray arr = cnpypp::npy_load("visit_s.npy");
+
+  // f receives the tuple range of the matching alternative
+  auto const first_double = [](auto r) -> double {
+    using value_type =
+        typename std::iterator_traits<decltype(r.begin())>::value_type;
+    if constexpr (std::is_same_v<value_type, std::tuple<int32_t, double>>) {
+      return std::get<1>(*r.begin());
+    } else {
+      return -1;
+    }
+  };
+  CHECK((cnpypp::visit<std::tuple<int64_t, double>,
+                       std::tuple<int32_t, double>>(arr, first_double) == 0.5));
+
+  // no matching alternative, or none given
+  CHECK(throws([&]() {
+    cnpypp::visit<std::tuple<int32_t, float>>(arr, first_double);
+  }));
+  CHECK(throws([&]() { cnpypp::visit(arr, first_double); }));
+
+  // strings have no element type to dispatch to
+  std::vector<std::string> const names{"a", "bc"};
+  cnpypp::npy_save("visit_str.npy", names.begin(), {names.size()},
+                   cnpypp::save_as<cnpypp::fixed_string<4>>);
+  CHECK(throws([&]() {
+    cnpypp::visit(cnpypp::npy_load("visit_str.npy"),
+                  [](auto s) { return s.size(); });
+  }));
+
+  return true;
+}
+
+int main() {
+  if (!scalar_types() || !structured_and_unsupported()) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -28,7 +28,9 @@ enum cnpypp_data_type {
   cnpypp_uint64 = 7,
   cnpypp_float32 = 8,
   cnpypp_float64 = 9,
-  cnpypp_float128 = 10
+  cnpypp_float128 = 10,
+  cnpypp_float16 = 11,
+  cnpypp_bfloat16 = 12
 };
 
 uint32_t _crc32(unsigned long int, uint8_t const*,
@@ -39,6 +41,12 @@ struct cnpypp_npyarray_handle;
 int cnpypp_npy_save(char const* fname, enum cnpypp_data_type, void const* start,
                     size_t const* shape, size_t rank, char const* mode,
                     enum cnpypp_memory_order);
+// like cnpypp_npy_save(), but converts the data to target_dtype; returns -1
+// on errors, including unknown data types
+int cnpypp_npy_save_as(char const* fname, enum cnpypp_data_type,
+                       void const* start, size_t const* shape, size_t rank,
+                       char const* mode, enum cnpypp_memory_order,
+                       enum cnpypp_data_type target_dtype);
 int cnpypp_npy_save_1d(char const* fname, enum cnpypp_data_type,
                        void const* start, size_t const num_elem,
                        char const* mode);
@@ -50,6 +58,14 @@ int cnpypp_npz_save(char const* zipname, char const* fname,
                     enum cnpypp_memory_order);
 #endif
 
+#ifndef NO_LIBZIP
+int cnpypp_npz_save_as(char const* zipname, char const* fname,
+                       enum cnpypp_data_type dtype, void const* data,
+                       size_t const* shape, size_t rank, char const* mode,
+                       enum cnpypp_memory_order,
+                       enum cnpypp_data_type target_dtype);
+#endif
+
 #ifndef NO_LIBZIP
 int cnpypp_npz_save_1d(char const* zipname, char const* fname,
                        enum cnpypp_data_type dtype, void const* data,
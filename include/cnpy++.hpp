@@ -14,6 +14,7 @@
 #include <functional>
 #include <iomanip>
 #include <iterator>
+#include <limits>
 #include <map>
 #include <memory>
 #include <numeric>
@@ -22,6 +23,7 @@
 #include <stdint.h>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -42,21 +44,36 @@
 #endif
 
 #include <cnpy++.h>
+#include <cnpy++/bits.hpp>
 #include <cnpy++/buffer.hpp>
+#include <cnpy++/convert.hpp>
+#include <cnpy++/fixed_string.hpp>
+#include <cnpy++/half.hpp>
 #include <cnpy++/map_type.hpp>
+#include <cnpy++/mdspan.hpp>
+#include <cnpy++/platform.hpp>
+#include <cnpy++/sink.hpp>
 #include <cnpy++/stride_iterator.hpp>
+#include <cnpy++/struct_util.hpp>
 #include <cnpy++/tuple_util.hpp>
 
 namespace cnpypp {
-template <typename T>
 #if defined(MSGSL_SPAN)
-using span = gsl::span<T>;
+using gsl::dynamic_extent;
+template <typename T, size_t Extent = dynamic_extent>
+using span = gsl::span<T, Extent>;
 #elif defined(GSL_LITE_SPAN)
-using span = gsl_lite::span<T>;
+using gsl_lite::dynamic_extent;
+template <typename T, size_t Extent = dynamic_extent>
+using span = gsl_lite::span<T, Extent>;
 #elif defined(BOOST_SPAN)
-using span = boost::span<T>;
+using boost::dynamic_extent;
+template <typename T, size_t Extent = dynamic_extent>
+using span = boost::span<T, Extent>;
 #else
-using span = std::span<T>;
+using std::dynamic_extent;
+template <typename T, size_t Extent = dynamic_extent>
+using span = std::span<T, Extent>;
 #endif
 
 namespace detail {
@@ -89,21 +106,182 @@ enum class MemoryOrder {
   RowMajor = C
 };
 
+// iterates over a sub-array field of the records of a structured array,
+// yielding a contiguous span<T, N> per record
+template <typename T, size_t N>
+class subarray_iterator
+    : public boost::stl_interfaces::proxy_iterator_interface<
+          subarray_iterator<T, N>, std::random_access_iterator_tag,
+          span<T, N>> {
+public:
+  subarray_iterator(std::byte* ptr, std::ptrdiff_t stride)
+      : ptr_{ptr}, stride_{stride} {}
+  subarray_iterator() : ptr_{nullptr}, stride_{} {}
+
+  span<T, N> operator*() const {
+    return span<T, N>{reinterpret_cast<T*>(ptr_), N};
+  }
+
+  subarray_iterator& operator+=(std::ptrdiff_t n) {
+    ptr_ += n * stride_;
+    return *this;
+  }
+
+  bool operator==(subarray_iterator const& other) const {
+    return ptr_ == other.ptr_;
+  }
+
+  std::ptrdiff_t operator-(subarray_iterator const& other) const {
+    return (ptr_ - other.ptr_) / stride_;
+  }
+
+private:
+  std::byte* ptr_;
+  std::ptrdiff_t stride_;
+};
+
+// Lightweight view onto (a part of) an array. Views share the underlying
+// buffer, which stays alive as long as any view refers to it, and
+// describe their elements by a byte offset, a shape and byte strides per
+// axis. Slicing, selecting and transposing only create new views and never
+// copy data; views are cheap to copy and can be passed to other threads.
+class NpyArrayView {
+public:
+  NpyArrayView(std::shared_ptr<Buffer> buffer, std::ptrdiff_t offset,
+               std::vector<size_t> shape, std::vector<std::ptrdiff_t> strides,
+               std::vector<size_t> word_sizes,
+               std::vector<std::string> labels);
+
+  std::vector<size_t> const& shape() const { return shape_; }
+  std::vector<std::ptrdiff_t> const& strides() const { return strides_; }
+  std::vector<size_t> const& word_sizes() const { return word_sizes_; }
+  std::vector<std::string> const& labels() const { return labels_; }
+
+  size_t rank() const { return shape_.size(); }
+  size_t num_vals() const {
+    return std::accumulate(shape_.begin(), shape_.end(), size_t{1},
+                           std::multiplies<size_t>());
+  }
+  size_t total_value_size() const { return total_value_size_; }
+
+  // elements [begin, end) with the given step along axis
+  NpyArrayView slice(size_t axis, size_t begin, size_t end,
+                     size_t step = 1) const;
+
+  // the sub-array at index along axis, which is removed
+  NpyArrayView select(size_t axis, size_t index) const;
+
+  // same as select(0, index)
+  NpyArrayView row(size_t index) const { return select(0, index); }
+
+  // reverses the order of the axes
+  NpyArrayView transpose() const;
+
+  // permutes the axes like numpy.transpose(a, axes)
+  NpyArrayView transpose(cnpypp::span<size_t const> axes) const;
+
+  // true if the elements are contiguous in C (or Fortran) order
+  bool is_contiguous(MemoryOrder order = MemoryOrder::C) const;
+
+  // pointer to the first element (index 0 along all axes)
+  template <typename T> T* data() const {
+    return reinterpret_cast<T*>(buffer_->data() + offset_);
+  }
+
+  template <typename T> T& at(cnpypp::span<size_t const> index) const {
+    return *reinterpret_cast<T*>(buffer_->data() + byte_offset(index));
+  }
+
+  template <typename T> T& at(std::initializer_list<size_t> index) const {
+    return at<T>(cnpypp::span<size_t const>{std::data(index), index.size()});
+  }
+
+  // iterates over all elements in C order; requires that the elements can
+  // be reached with a single stride, e.g. rows, columns or strided slices
+  template <typename T> subrange<stride_iterator<T>> make_range() const {
+    std::ptrdiff_t const stride = flat_stride();
+    std::byte* const begin = buffer_->data() + offset_;
+
+    return subrange{stride_iterator<T>{begin, stride},
+                    stride_iterator<T>{begin + stride * num_vals(), stride}};
+  }
+
+  // like NpyArray::column_range()
+  template <typename TValueType>
+  subrange<stride_iterator<TValueType>>
+  column_range(std::string_view name) const {
+    auto const it = std::find(labels_.cbegin(), labels_.cend(), name);
+
+    if (it == labels_.cend()) {
+      std::stringstream ss;
+      ss << "column_range: " << std::quoted(name) << " not found in labels";
+      throw std::runtime_error{ss.str().c_str()};
+    }
+
+    std::ptrdiff_t const d = std::distance(labels_.cbegin(), it);
+
+    if (word_sizes_.at(d) != sizeof(TValueType)) {
+      throw std::runtime_error{
+          "column_range: word sizes of requested type and data do not match"};
+    }
+
+    std::ptrdiff_t const field_offset = std::accumulate(
+        word_sizes_.cbegin(), std::next(word_sizes_.cbegin(), d),
+        std::ptrdiff_t{0});
+    std::ptrdiff_t const stride = flat_stride();
+    std::byte* const begin = buffer_->data() + offset_ + field_offset;
+
+    return subrange{
+        stride_iterator<TValueType>{begin, stride},
+        stride_iterator<TValueType>{begin + stride * num_vals(), stride}};
+  }
+
+private:
+  std::ptrdiff_t byte_offset(cnpypp::span<size_t const> index) const;
+
+  // stride that reaches all elements in C order, throws if there is none
+  std::ptrdiff_t flat_stride() const;
+
+  std::shared_ptr<Buffer> buffer_;
+  std::ptrdiff_t offset_;
+  std::vector<size_t> shape_;
+  std::vector<std::ptrdiff_t> strides_;
+  std::vector<size_t> word_sizes_;
+  std::vector<std::string> labels_;
+  size_t total_value_size_;
+};
+
 struct NpyArray {
   NpyArray(NpyArray&& other)
       : shape{std::move(other.shape)}, word_sizes{std::move(other.word_sizes)},
-        memory_order{other.memory_order}, num_vals{other.num_vals},
-        total_value_size{other.total_value_size}, buffer{std::move(
-                                                      other.buffer)} {}
+        data_types{std::move(other.data_types)},
+        labels{std::move(other.labels)},
+        field_shapes{std::move(other.field_shapes)},
+        memory_order{other.memory_order},
+        num_vals{other.num_vals}, total_value_size{other.total_value_size},
+        buffer{std::move(other.buffer)} {}
+
+  // for arrays without sub-array fields
+  NpyArray(std::vector<size_t> _shape, std::vector<size_t> _word_sizes,
+           std::vector<char> _data_types, std::vector<std::string> _labels,
+           MemoryOrder _memory_order, std::unique_ptr<Buffer> _buffer)
+      : NpyArray{std::move(_shape),
+                 _word_sizes,
+                 std::move(_data_types),
+                 std::move(_labels),
+                 std::vector<std::vector<size_t>>(_word_sizes.size()),
+                 _memory_order,
+                 std::move(_buffer)} {}
 
   NpyArray(std::vector<size_t> _shape, std::vector<size_t> _word_sizes,
-           std::vector<std::string> _labels, MemoryOrder _memory_order,
-           std::unique_ptr<Buffer> _buffer)
-      : shape{std::move(_shape)},
-        word_sizes{std::move(_word_sizes)}, labels{std::move(_labels)},
-        memory_order{_memory_order}, num_vals{std::accumulate(
-                                         shape.begin(), shape.end(), size_t{1},
-                                         std::multiplies<size_t>())},
+           std::vector<char> _data_types, std::vector<std::string> _labels,
+           std::vector<std::vector<size_t>> _field_shapes,
+           MemoryOrder _memory_order, std::unique_ptr<Buffer> _buffer)
+      : shape{std::move(_shape)}, word_sizes{std::move(_word_sizes)},
+        data_types{std::move(_data_types)}, labels{std::move(_labels)},
+        field_shapes{std::move(_field_shapes)}, memory_order{_memory_order},
+        num_vals{std::accumulate(shape.begin(), shape.end(), size_t{1},
+                                 std::multiplies<size_t>())},
         total_value_size{std::accumulate(word_sizes.begin(), word_sizes.end(),
                                          size_t{0}, std::plus<size_t>())},
         buffer{std::move(_buffer)} {}
@@ -122,9 +300,33 @@ struct NpyArray {
 
   size_t num_bytes() const { return num_vals * total_value_size; }
 
+  // view onto the whole array, sharing its memory
+  NpyArrayView view() const;
+
+  // makes modifications durable for arrays backed by a writable mapping
+  void sync() { buffer->sync(); }
+
+  // for memory-mapped arrays, asks the OS to read the given byte range of
+  // the data ahead of access or to release its memory, respectively
+  void prefetch(size_t offset = 0,
+                size_t length = std::numeric_limits<size_t>::max()) {
+    if (offset < num_bytes()) {
+      buffer->prefetch(offset, std::min(length, num_bytes() - offset));
+    }
+  }
+
+  void evict(size_t offset = 0,
+             size_t length = std::numeric_limits<size_t>::max()) {
+    if (offset < num_bytes()) {
+      buffer->evict(offset, std::min(length, num_bytes() - offset));
+    }
+  }
+
   bool compare_metadata(NpyArray const& other) const {
     return shape == other.shape && word_sizes == other.word_sizes &&
-           labels == other.labels && memory_order == other.memory_order;
+           data_types == other.data_types && labels == other.labels &&
+           field_shapes == other.field_shapes &&
+           memory_order == other.memory_order;
   }
 
   bool operator==(NpyArray const& other) const {
@@ -150,6 +352,49 @@ struct NpyArray {
     return subrange{cbegin<T>(), cend<T>()};
   }
 
+  // N-dimensional view with compile-time rank; Layout has to be
+  // layout_right for C-order and layout_left for Fortran-order arrays.
+  // Data type (or the fields of a struct registered with CNPYPP_STRUCT), rank
+  // and memory order are checked once here.
+  template <typename T, size_t Rank, typename Layout = layout_right>
+  mdspan<T, Rank, Layout> typed_view() {
+    check_typed_view<T, Rank, Layout>();
+    return mdspan<T, Rank, Layout>{data<T>(), extents<Rank>()};
+  }
+
+  template <typename T, size_t Rank, typename Layout = layout_right>
+  mdspan<T const, Rank, Layout> typed_view() const {
+    check_typed_view<T, Rank, Layout>();
+    return mdspan<T const, Rank, Layout>{data<T>(), extents<Rank>()};
+  }
+
+  // true if the fields (including padding) are those of struct T, i.e. if
+  // struct_range<T>() can be used
+  template <typename T> bool matches_struct() const {
+    auto const fields = struct_fields<T>();
+    return fields.data_types == data_types && fields.word_sizes == word_sizes &&
+           fields.field_shapes == field_shapes &&
+           std::equal(fields.labels.cbegin(), fields.labels.cend(),
+                      labels.cbegin(), labels.cend(),
+                      [](std::string_view a, std::string_view b) {
+                        // padding must not stand in for a (bfloat16) field
+                        return a.empty() == b.empty();
+                      });
+  }
+
+  // zero-copy range over the records of a structured array, interpreted as
+  // struct T registered with CNPYPP_STRUCT. The fields are checked against
+  // the data types and sizes in the header.
+  template <typename T> subrange<T*, T*> struct_range() {
+    check_struct<T>();
+    return subrange{begin<T>(), end<T>()};
+  }
+
+  template <typename T> subrange<T const*, T const*> struct_range() const {
+    check_struct<T>();
+    return subrange{cbegin<T>(), cend<T>()};
+  }
+
   template <typename... TArgs>
   subrange<tuple_iterator<std::tuple<TArgs...>>>
   tuple_range(bool force_check = false) {
@@ -175,7 +420,7 @@ struct NpyArray {
           "tuple_range: word sizes do not match requested types");
     } else {
       return subrange{
-          tuple_iterator<add_const_t<std::tuple<TArgs...>>>{buffer.get()},
+          tuple_iterator<add_const_t<std::tuple<TArgs...>>>{buffer->data()},
           tuple_iterator<add_const_t<std::tuple<TArgs...>>>{
               buffer->data() + num_vals * total_value_size}};
     }
@@ -183,74 +428,172 @@ struct NpyArray {
 
   template <typename TValueType>
   subrange<stride_iterator<TValueType>> column_range(std::string_view name) {
-    // TODO: refactor this to remove code duplication
-    // see Scott Meyers "Avoid Duplication in const and Non-const Member
-    // Function"
-
-    if (auto it = std::find(labels.cbegin(), labels.cend(), name);
-        it == labels.cend()) {
-      std::stringstream ss;
-      ss << "column_range: " << std::quoted(name) << " not found in labels";
-      throw std::runtime_error{ss.str().c_str()};
-    } else {
-      std::ptrdiff_t const d = std::distance(labels.cbegin(), it);
-
-      if (word_sizes.at(d) != sizeof(TValueType)) {
-        throw std::runtime_error{
-            "column_range: word sizes of requested type and data do not match"};
-      }
-
-      ptrdiff_t const offset =
-          std::accumulate(word_sizes.cbegin(),
-                          std::next(word_sizes.cbegin(), d), std::ptrdiff_t{0});
-
-      auto beg =
-          stride_iterator<TValueType>{buffer.get() + offset, total_value_size};
-      auto end = stride_iterator<TValueType>{buffer.get() + offset +
-                                                 total_value_size * num_vals,
-                                             total_value_size};
-      return subrange{beg, end};
-    }
+    auto const offset = column_offset(name, sizeof(TValueType));
+    auto const stride = static_cast<std::ptrdiff_t>(total_value_size);
+    auto beg = stride_iterator<TValueType>{buffer->data() + offset, stride};
+    auto end = stride_iterator<TValueType>{
+        buffer->data() + offset + total_value_size * num_vals, stride};
+    return subrange{beg, end};
   }
 
   template <typename TValueType>
   subrange<stride_iterator<TValueType const>>
   column_range(std::string_view name) const {
-    if (auto it = std::find(labels.cbegin(), labels.cend(), name);
-        it == labels.cend()) {
-      std::stringstream ss;
-      ss << "column_range: " << std::quoted(name) << " not found in labels";
-      throw std::runtime_error{ss.str().c_str()};
-    } else {
-      std::ptrdiff_t const d = std::distance(labels.cbegin(), it);
+    auto const offset = column_offset(name, sizeof(TValueType));
+    auto const stride = static_cast<std::ptrdiff_t>(total_value_size);
+    auto beg =
+        stride_iterator<TValueType const>{buffer->data() + offset, stride};
+    auto end = stride_iterator<TValueType const>{
+        buffer->data() + offset + total_value_size * num_vals, stride};
+    return subrange{beg, end};
+  }
 
-      if (word_sizes.at(d) != sizeof(TValueType)) {
-        throw std::runtime_error{
-            "column_range: word sizes of requested type and data do not match"};
-      }
+  // range over a sub-array field with N elements of type TValueType per
+  // record (e.g. ('pos', '<f8', (3,))), yielding span<TValueType const, N>
+  template <typename TValueType, size_t N>
+  subrange<subarray_iterator<TValueType, N>>
+  column_range(std::string_view name) {
+    auto const offset = column_offset(name, N * sizeof(TValueType));
+    auto const stride = static_cast<std::ptrdiff_t>(total_value_size);
+    return subrange{subarray_iterator<TValueType, N>{buffer->data() + offset,
+                                                     stride},
+                    subarray_iterator<TValueType, N>{
+                        buffer->data() + offset + num_bytes(), stride}};
+  }
 
-      ptrdiff_t const offset =
-          std::accumulate(word_sizes.cbegin(),
-                          std::next(word_sizes.cbegin(), d), std::ptrdiff_t{0});
+  template <typename TValueType, size_t N>
+  subrange<subarray_iterator<TValueType const, N>>
+  column_range(std::string_view name) const {
+    auto const offset = column_offset(name, N * sizeof(TValueType));
+    auto const stride = static_cast<std::ptrdiff_t>(total_value_size);
+    return subrange{subarray_iterator<TValueType const, N>{
+                        buffer->data() + offset, stride},
+                    subarray_iterator<TValueType const, N>{
+                        buffer->data() + offset + num_bytes(), stride}};
+  }
 
-      auto beg = stride_iterator<TValueType const>{buffer.get() + offset,
-                                                   total_value_size};
-      auto end = stride_iterator<TValueType const>{
-          buffer.get() + offset + total_value_size * num_vals,
-          total_value_size};
-      return subrange{beg, end};
+  // zero-copy range of views onto the strings of an 'S' (TChar = char) or
+  // 'U' (TChar = char32_t) array, without trailing NULs
+  template <typename TChar = char>
+  subrange<fixed_string_iterator<TChar>> string_range() const {
+    if (data_types.size() != 1 ||
+        data_types.front() != detail::string_data_type<TChar>()) {
+      throw std::runtime_error(
+          "string_range: data type does not match requested character type");
     }
+
+    return make_string_range<TChar>(0, total_value_size);
+  }
+
+  // same for the 'S' or 'U' field name of a structured array
+  template <typename TChar = char>
+  subrange<fixed_string_iterator<TChar>>
+  string_column_range(std::string_view name) const {
+    size_t const d = field_index(name);
+
+    if (data_types[d] != detail::string_data_type<TChar>()) {
+      throw std::runtime_error("string_column_range: data type does not match "
+                               "requested character type");
+    }
+
+    return make_string_range<TChar>(field_offset(d), word_sizes[d]);
   }
 
   std::vector<size_t> const shape;
   std::vector<size_t> const word_sizes;
+  std::vector<char> const data_types; // descriptor characters as in map_type()
   std::vector<std::string> const labels;
+  // sub-array shape of each field, empty for scalar fields
+  std::vector<std::vector<size_t>> const field_shapes;
   MemoryOrder const memory_order;
   size_t const num_vals;
   size_t const total_value_size;
 
 private:
-  std::unique_ptr<Buffer> buffer;
+  std::shared_ptr<Buffer> buffer;
+
+  template <typename T, size_t Rank, typename Layout>
+  void check_typed_view() const {
+    if constexpr (detail::has_struct_info<T>::value) {
+      if (!matches_struct<T>()) {
+        throw std::runtime_error(
+            "typed_view: fields do not match requested struct");
+      }
+    } else if (!labels.empty() || data_types.at(0) != map_type(T{}) ||
+               word_sizes.at(0) != sizeof(T)) {
+      throw std::runtime_error(
+          "typed_view: data type does not match requested type");
+    }
+
+    if (sizeof(T) != total_value_size) {
+      throw std::runtime_error(
+          "typed_view: element size does not match requested type");
+    } else if (shape.size() != Rank) {
+      throw std::runtime_error("typed_view: rank does not match");
+    } else if (Rank > 1 && (memory_order == MemoryOrder::C) !=
+                               std::is_same_v<Layout, layout_right>) {
+      throw std::runtime_error(
+          "typed_view: layout does not match memory order");
+    }
+  }
+
+  template <typename T> void check_struct() const {
+    if (!matches_struct<T>()) {
+      throw std::runtime_error(
+          "struct_range: fields do not match requested struct");
+    } else if (reinterpret_cast<uintptr_t>(buffer->data()) % alignof(T) != 0) {
+      throw std::runtime_error("struct_range: data not sufficiently aligned");
+    }
+  }
+
+  size_t field_index(std::string_view name) const {
+    auto const it = std::find(labels.cbegin(), labels.cend(), name);
+
+    if (it == labels.cend()) {
+      std::stringstream ss;
+      ss << "column_range: " << std::quoted(name) << " not found in labels";
+      throw std::runtime_error{ss.str().c_str()};
+    }
+
+    return std::distance(labels.cbegin(), it);
+  }
+
+  // byte offset of field d within the records
+  std::ptrdiff_t field_offset(size_t d) const {
+    return std::accumulate(word_sizes.cbegin(),
+                           std::next(word_sizes.cbegin(), d),
+                           std::ptrdiff_t{0});
+  }
+
+  // byte offset of field name, which has to be of size word_size
+  std::ptrdiff_t column_offset(std::string_view name, size_t word_size) const {
+    size_t const d = field_index(name);
+
+    if (word_sizes[d] != word_size) {
+      throw std::runtime_error{
+          "column_range: word sizes of requested type and data do not match"};
+    }
+
+    return field_offset(d);
+  }
+
+  template <typename TChar>
+  subrange<fixed_string_iterator<TChar>>
+  make_string_range(std::ptrdiff_t offset, size_t size) const {
+    auto const* const first = buffer->data() + offset;
+    size_t const width = size / sizeof(TChar);
+    auto const stride = static_cast<std::ptrdiff_t>(total_value_size);
+
+    return subrange{
+        fixed_string_iterator<TChar>{first, width, stride},
+        fixed_string_iterator<TChar>{first + num_bytes(), width, stride}};
+  }
+
+  template <size_t Rank> std::array<size_t, Rank> extents() const {
+    std::array<size_t, Rank> result;
+    std::copy_n(shape.begin(), Rank, result.begin());
+    return result;
+  }
 
   template <typename... TArgs> bool compare_word_sizes() const {
     auto const& requested_type_sizes =
@@ -261,6 +604,162 @@ private:
   }
 };
 
+namespace detail {
+// calls f with a value-initialized object of the element type given by the
+// descriptor character and size in bytes (as in map_type()). 'V2' is any
+// 2-byte void type, which is taken as bfloat16 only if VoidAsBfloat16 is set.
+template <bool VoidAsBfloat16, typename F>
+decltype(auto) dispatch_dtype(char data_type, size_t word_size, F&& f) {
+  switch (data_type) {
+  case 'b':
+    if (word_size == sizeof(bool)) {
+      return f(bool{});
+    }
+    break;
+  case 'i':
+    switch (word_size) {
+    case 1:
+      return f(int8_t{});
+    case 2:
+      return f(int16_t{});
+    case 4:
+      return f(int32_t{});
+    case 8:
+      return f(int64_t{});
+    }
+    break;
+  case 'u':
+    switch (word_size) {
+    case 1:
+      return f(uint8_t{});
+    case 2:
+      return f(uint16_t{});
+    case 4:
+      return f(uint32_t{});
+    case 8:
+      return f(uint64_t{});
+    }
+    break;
+  case 'f':
+    if (word_size == sizeof(float16)) {
+      return f(float16{});
+    } else if (word_size == sizeof(float)) {
+      return f(float{});
+    } else if (word_size == sizeof(double)) {
+      return f(double{});
+    } else if (word_size == sizeof(long double)) {
+      return f(0.0L);
+    }
+    break;
+  case 'c':
+    if (word_size == sizeof(std::complex<float>)) {
+      return f(std::complex<float>{});
+    } else if (word_size == sizeof(std::complex<double>)) {
+      return f(std::complex<double>{});
+    } else if (word_size == sizeof(std::complex<long double>)) {
+      return f(std::complex<long double>{});
+    }
+    break;
+  case 'V':
+    if constexpr (VoidAsBfloat16) {
+      if (word_size == sizeof(bfloat16)) {
+        return f(bfloat16{});
+      }
+    }
+    break;
+  }
+
+  throw std::runtime_error(std::string{"visit: unsupported data type '"} +
+                           data_type + std::to_string(word_size) + "'");
+}
+
+template <typename Tup, typename TArray>
+bool matches_tuple(TArray& array) {
+  if constexpr (has_struct_info_v<Tup>) {
+    return array.template matches_struct<Tup>();
+  } else {
+    auto const& dtypes = tuple_info<Tup>::data_types;
+    auto const& sizes = tuple_info<Tup>::element_sizes;
+    return std::equal(dtypes.cbegin(), dtypes.cend(),
+                      array.data_types.cbegin(), array.data_types.cend()) &&
+           std::equal(sizes.cbegin(), sizes.cend(), array.word_sizes.cbegin(),
+                      array.word_sizes.cend()) &&
+           tuple_info<Tup>::field_shapes() == array.field_shapes &&
+           std::none_of(array.labels.cbegin(), array.labels.cend(),
+                        [](std::string const& l) { return l.empty(); });
+  }
+}
+
+template <typename TArray, typename F, typename Tup, typename... TRest>
+decltype(auto) visit_tuples(TArray& array, F&& f) {
+  if (matches_tuple<Tup>(array)) {
+    if constexpr (has_struct_info_v<Tup>) {
+      return f(array.template struct_range<Tup>());
+    } else {
+      using tuple_type =
+          std::conditional_t<std::is_const_v<TArray>, add_const_t<Tup>, Tup>;
+      auto* const ptr =
+          const_cast<std::byte*>(array.template data<std::byte>());
+      return f(subrange{tuple_iterator<tuple_type>{ptr},
+                        tuple_iterator<tuple_type>{ptr + array.num_bytes()}});
+    }
+  }
+
+  if constexpr (sizeof...(TRest) > 0) {
+    return visit_tuples<TArray, F, TRest...>(array, std::forward<F>(f));
+  } else {
+    throw std::runtime_error(
+        "visit: structured data type matches none of the given tuples");
+  }
+}
+
+template <typename... TTuples, typename TArray, typename F>
+decltype(auto) visit_impl(TArray& array, F&& f) {
+  constexpr bool void_as_bfloat16 = (std::is_same_v<TTuples, bfloat16> || ...);
+  static_assert(!void_as_bfloat16 || sizeof...(TTuples) == 1,
+                "visit<bfloat16> cannot be combined with tuple types");
+
+  if constexpr (sizeof...(TTuples) > 0 && !void_as_bfloat16) {
+    if (!array.labels.empty()) {
+      return visit_tuples<TArray, F, TTuples...>(array, std::forward<F>(f));
+    }
+  }
+
+  if (!array.labels.empty() || array.data_types.size() != 1) {
+    throw std::runtime_error("visit: structured data type not supported");
+  }
+
+  return dispatch_dtype<void_as_bfloat16>(
+      array.data_types.front(), array.word_sizes.front(),
+      [&](auto value) -> decltype(auto) {
+        using value_type =
+            std::conditional_t<std::is_const_v<TArray>,
+                               decltype(value) const, decltype(value)>;
+        return f(cnpypp::span<value_type>{
+            array.template data<value_type>(), array.num_vals});
+      });
+}
+} // namespace detail
+
+// Calls f with a cnpypp::span<T> over the data of array, where T is the
+// element type corresponding to its dtype, so that f (usually a generic
+// lambda) is instantiated once per element type. Structured arrays are
+// supported for the std::tuple types or registered structs given as template
+// arguments, e.g. visit<std::tuple<int32_t, double>>(array, f); f receives
+// the same range as from tuple_range() or struct_range() for those. All
+// instantiations of f have to return the same type. bfloat16 arrays are
+// stored as 'V2', which is ambiguous, so they are only dispatched with
+// visit<bfloat16>(array, f); otherwise 'V2' is unsupported.
+template <typename... TTuples, typename F>
+decltype(auto) visit(NpyArray& array, F&& f) {
+  return detail::visit_impl<TTuples...>(array, std::forward<F>(f));
+}
+
+template <typename... TTuples, typename F>
+decltype(auto) visit(NpyArray const& array, F&& f) {
+  return detail::visit_impl<TTuples...>(array, std::forward<F>(f));
+}
+
 using npz_t = std::map<std::string, NpyArray>;
 
 char BigEndianTest();
@@ -271,24 +770,90 @@ std::vector<char> create_npy_header(cnpypp::span<size_t const> shape,
                                     char dtype, int size,
                                     MemoryOrder = MemoryOrder::C);
 
+// header for structured arrays without sub-array fields
 std::vector<char> create_npy_header(cnpypp::span<size_t const> shape,
                                     cnpypp::span<std::string_view const> labels,
                                     cnpypp::span<char const> dtypes,
                                     cnpypp::span<size_t const> sizes,
                                     MemoryOrder memory_order);
 
+// header for structured arrays. sizes are the sizes of whole fields, i.e.
+// including all elements of sub-array fields; field_shapes may be empty if
+// no field has a sub-array shape.
+std::vector<char>
+create_npy_header(cnpypp::span<size_t const> shape,
+                  cnpypp::span<std::string_view const> labels,
+                  cnpypp::span<char const> dtypes,
+                  cnpypp::span<size_t const> sizes,
+                  cnpypp::span<std::vector<size_t> const> field_shapes,
+                  MemoryOrder memory_order);
+
+// pads header with spaces to size bytes (e.g. to leave room for growing
+// shape entries) and adjusts the header length field accordingly
+void pad_npy_header(std::vector<char>& header, size_t size);
+
+// size of a header for arrays with the given row shape, padded such that the
+// first axis can hold any number of rows, rounded up to multiples of 64
+size_t growable_npy_header_size(cnpypp::span<size_t const> row_shape,
+                                char dtype, size_t size);
+
+// header for arrays of T (arithmetic type or struct registered with
+// CNPYPP_STRUCT)
+template <typename T>
+std::vector<char> create_npy_header(cnpypp::span<size_t const> shape,
+                                    MemoryOrder memory_order) {
+  if constexpr (has_struct_info_v<T>) {
+    auto const fields = struct_fields<T>();
+    return create_npy_header(shape, fields.labels, fields.data_types,
+                             fields.word_sizes, fields.field_shapes,
+                             memory_order);
+  } else {
+    return create_npy_header(shape, map_type(T{}), sizeof(T), memory_order);
+  }
+}
+
+// The overloads without field_shapes throw if the array has sub-array fields.
 void parse_npy_header(std::istream& fs, std::vector<size_t>& word_sizes,
                       std::vector<char>& data_types,
                       std::vector<std::string>& labels,
                       std::vector<size_t>& shape,
                       cnpypp::MemoryOrder& memory_order);
 
+void parse_npy_header(std::istream& fs, std::vector<size_t>& word_sizes,
+                      std::vector<char>& data_types,
+                      std::vector<std::string>& labels,
+                      std::vector<std::vector<size_t>>& field_shapes,
+                      std::vector<size_t>& shape,
+                      cnpypp::MemoryOrder& memory_order);
+
 void parse_npy_header(std::istream::char_type const* buffer,
                       std::vector<size_t>& word_sizes,
                       std::vector<char>& data_types,
                       std::vector<std::string>& labels,
                       std::vector<size_t>& shape, MemoryOrder& memory_order);
 
+void parse_npy_header(std::istream::char_type const* buffer,
+                      std::vector<size_t>& word_sizes,
+                      std::vector<char>& data_types,
+                      std::vector<std::string>& labels,
+                      std::vector<std::vector<size_t>>& field_shapes,
+                      std::vector<size_t>& shape, MemoryOrder& memory_order);
+
+// bounds-checked variants; return the size of the header including the
+// preamble, i.e. the offset of the data
+size_t parse_npy_header(cnpypp::span<std::istream::char_type const> buffer,
+                        std::vector<size_t>& word_sizes,
+                        std::vector<char>& data_types,
+                        std::vector<std::string>& labels,
+                        std::vector<size_t>& shape, MemoryOrder& memory_order);
+
+size_t parse_npy_header(cnpypp::span<std::istream::char_type const> buffer,
+                        std::vector<size_t>& word_sizes,
+                        std::vector<char>& data_types,
+                        std::vector<std::string>& labels,
+                        std::vector<std::vector<size_t>>& field_shapes,
+                        std::vector<size_t>& shape, MemoryOrder& memory_order);
+
 void parse_npy_dict(cnpypp::span<std::istream::char_type const> buffer,
                     std::vector<size_t>& word_sizes,
                     std::vector<char>& data_types,
@@ -296,12 +861,362 @@ void parse_npy_dict(cnpypp::span<std::istream::char_type const> buffer,
                     std::vector<size_t>& shape,
                     cnpypp::MemoryOrder& memory_order);
 
+void parse_npy_dict(cnpypp::span<std::istream::char_type const> buffer,
+                    std::vector<size_t>& word_sizes,
+                    std::vector<char>& data_types,
+                    std::vector<std::string>& labels,
+                    std::vector<std::vector<size_t>>& field_shapes,
+                    std::vector<size_t>& shape,
+                    cnpypp::MemoryOrder& memory_order);
+
 npz_t npz_load(std::string const& fname);
 
 NpyArray npz_load(std::string const& fname, std::string const& varname);
 
+#ifndef NO_LIBZIP
+enum class SparseFormat { CSR, CSC };
+
+// Compressed sparse row (CSR) or column (CSC) matrix in the layout of
+// scipy.sparse. The arrays share one buffer, either a single allocation or
+// the mapping of the archive.
+struct SparseMatrix {
+  SparseFormat format;
+  std::array<size_t, 2> shape;
+  NpyArray data;    // the nnz() stored values
+  NpyArray indices; // column (CSR) resp. row (CSC) index of each value (int32
+                    // or int64)
+  NpyArray indptr;  // the values of row (CSR) resp. column (CSC) i are
+                    // [indptr[i], indptr[i + 1]) (int32 or int64)
+
+  size_t nnz() const { return data.num_vals; }
+};
+
+// loads a matrix saved by scipy.sparse.save_npz() in csr or csc format. With
+// memory_mapped, the arrays are mapped from the file if the archive is stored
+// uncompressed (save_npz(..., compressed=False)) and read otherwise.
+SparseMatrix load_sparse_npz(std::string const& fname,
+                             bool memory_mapped = false);
+
+namespace detail {
+struct sparse_component {
+  void const* data;
+  size_t num_vals;
+  char data_type;
+  size_t word_size;
+};
+
+void save_sparse_npz(std::string const& fname, SparseFormat format,
+                     std::array<size_t, 2> shape, sparse_component data,
+                     sparse_component indices, sparse_component indptr,
+                     bool compressed);
+} // namespace detail
+
+// saves the matrix as scipy.sparse.save_npz() does, i.e. readable by
+// scipy.sparse.load_npz()
+void save_sparse_npz(std::string const& fname, SparseMatrix const& matrix,
+                     bool compressed = true);
+
+template <typename T, typename TIndex>
+void save_sparse_npz(std::string const& fname, SparseFormat format,
+                     std::array<size_t, 2> shape, cnpypp::span<T const> data,
+                     cnpypp::span<TIndex const> indices,
+                     cnpypp::span<TIndex const> indptr,
+                     bool compressed = true) {
+  static_assert(std::is_same_v<TIndex, int32_t> ||
+                    std::is_same_v<TIndex, int64_t>,
+                "scipy.sparse indices are int32 or int64");
+
+  detail::save_sparse_npz(
+      fname, format, shape,
+      {data.data(), data.size(), map_type(T{}), sizeof(T)},
+      {indices.data(), indices.size(), map_type(TIndex{}), sizeof(TIndex)},
+      {indptr.data(), indptr.size(), map_type(TIndex{}), sizeof(TIndex)},
+      compressed);
+}
+#endif
+
 NpyArray npy_load(std::string const& fname, bool memory_mapped = false);
 
+// memory-maps fname, applying the given access pattern hints
+NpyArray npy_load(std::string const& fname, MapHint hints);
+
+// creates fname with the header for an array of the given shape, element
+// type (descriptor character and size as in map_type()) and memory order,
+// extends it to its final size and returns an array mapped read-write onto
+// the data region. Writes to the array go to the file; use sync() to make
+// them durable.
+NpyArray npy_create_mapped(std::string const& fname,
+                           cnpypp::span<size_t const> shape, char data_type,
+                           size_t word_size,
+                           MemoryOrder memory_order = MemoryOrder::C);
+
+template <typename T>
+NpyArray npy_create_mapped(std::string const& fname,
+                           cnpypp::span<size_t const> shape,
+                           MemoryOrder memory_order = MemoryOrder::C) {
+  return npy_create_mapped(fname, shape, map_type(T{}), sizeof(T),
+                           memory_order);
+}
+
+template <typename T>
+NpyArray npy_create_mapped(std::string const& fname,
+                           std::initializer_list<size_t> const shape,
+                           MemoryOrder memory_order = MemoryOrder::C) {
+  return npy_create_mapped<T>(
+      fname, cnpypp::span<size_t const>{std::data(shape), shape.size()},
+      memory_order);
+}
+
+#ifdef CNPYPP_POSIX
+// Shared-memory objects (shm_open(), i.e. /dev/shm on Linux) containing a
+// plain NPY image, for handing arrays over between processes on one node.
+// npy_create_shm() creates the object name for an array of the given shape
+// and element type and returns it mapped read-write, so that it can be
+// filled in place. An existing object of that name is unlinked first, so
+// arrays already loaded from it keep their contents.
+NpyArray npy_create_shm(std::string const& name,
+                        cnpypp::span<size_t const> shape, char data_type,
+                        size_t word_size,
+                        MemoryOrder memory_order = MemoryOrder::C);
+
+template <typename T>
+NpyArray npy_create_shm(std::string const& name,
+                        cnpypp::span<size_t const> shape,
+                        MemoryOrder memory_order = MemoryOrder::C) {
+  return npy_create_shm(name, shape, map_type(T{}), sizeof(T), memory_order);
+}
+
+template <typename T>
+NpyArray npy_create_shm(std::string const& name,
+                        std::initializer_list<size_t> const shape,
+                        MemoryOrder memory_order = MemoryOrder::C) {
+  return npy_create_shm<T>(
+      name, cnpypp::span<size_t const>{std::data(shape), shape.size()},
+      memory_order);
+}
+
+// stores the data from start in the shared-memory object name
+template <typename TConstInputIterator>
+void npy_save_shm(std::string const& name, TConstInputIterator start,
+                  cnpypp::span<size_t const> shape,
+                  MemoryOrder memory_order = MemoryOrder::C) {
+  using value_type =
+      typename std::iterator_traits<TConstInputIterator>::value_type;
+
+  NpyArray array = npy_create_shm<value_type>(name, shape, memory_order);
+  std::copy_n(start, array.num_vals, array.data<value_type>());
+}
+
+template <typename TConstInputIterator>
+void npy_save_shm(std::string const& name, TConstInputIterator start,
+                  std::initializer_list<size_t> const shape,
+                  MemoryOrder memory_order = MemoryOrder::C) {
+  npy_save_shm(name, start,
+               cnpypp::span<size_t const>{std::data(shape), shape.size()},
+               memory_order);
+}
+
+// maps the shared-memory object name read-only without copying; the array
+// must not be written to
+NpyArray npy_load_shm(std::string const& name);
+
+// removes the name of a shared-memory object; mappings stay valid
+void npy_remove_shm(std::string const& name);
+#endif
+
+// reads an array from a stream without seeking, e.g. from a pipe
+NpyArray npy_load(std::istream& fs);
+
+#ifdef CNPYPP_POSIX
+// same as above for a POSIX file descriptor (pipe, socket, ...)
+NpyArray npy_load_fd(int fd);
+#endif
+
+// interprets the complete NPY file image in buffer without copying. The
+// returned array refers to the memory in buffer, which has to outlive it.
+NpyArray npy_load_from(cnpypp::span<std::byte const> buffer);
+
+// like above, but the returned array takes ownership of the memory, calling
+// release when it is destroyed
+NpyArray npy_load_from(cnpypp::span<std::byte const> buffer,
+                       std::function<void()> release);
+
+// loads fname and, if necessary, converts the data to the requested memory
+// order while copying them from the file
+NpyArray npy_load(std::string const& fname, MemoryOrder desired);
+
+// loads only the fields with the given names of the structured array in
+// fname, in this order, as a narrower structured array; a single scalar
+// field is returned as plain array of its type. The records are gathered
+// block-wise from a mapping of the file, so that only the selected fields
+// are copied.
+NpyArray npy_load_columns(std::string const& fname,
+                          std::vector<std::string_view> const& names);
+
+// Boolean array stored bit-packed as by np.packbits(): size bits in the
+// (size + 7) / 8 uint8 elements of bytes
+struct PackedBitArray {
+  NpyArray bytes;
+  size_t size;
+  BitOrder order;
+
+  bit_view bits() const { return {bytes.data<uint8_t>(), size, order}; }
+};
+
+// loads the first count bits (default: all) of fname bit-packed. Bool arrays
+// are packed chunk by chunk while reading, so that only the packed data are
+// held in memory; uint8 arrays are taken as already packed data (e.g. written
+// by np.packbits() or npy_save_packed()). Throws if count exceeds the number
+// of bools or bits in the file.
+PackedBitArray
+npy_load_packed(std::string const& fname,
+                size_t count = std::numeric_limits<size_t>::max(),
+                BitOrder order = BitOrder::Big);
+
+// saves the packed bytes of bits as uint8 array of shape (bits.num_bytes(),)
+// with the unused bits zeroed, as np.packbits() does. NPY headers can't hold
+// the number of bits, so use np.unpackbits(np.load(fname), count=...) or
+// npy_load_packed(fname, count) to read them back.
+void npy_save_packed(std::string const& fname, bit_view bits);
+
+// saves bits as bool array of shape (bits.size(),), unpacking chunk by chunk
+void npy_save_unpacked(std::string const& fname, bit_view bits);
+
+// Operand of a predicate. Integers are kept as such, so that they are
+// compared exactly with 64-bit fields even where long double has no more
+// precision than double.
+struct ScanOperand {
+  enum class Kind { Signed, Unsigned, Float };
+
+  template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+  ScanOperand(T value) {
+    if constexpr (std::is_floating_point_v<T>) {
+      kind = Kind::Float;
+      f = value;
+    } else if constexpr (std::is_signed_v<T>) {
+      kind = Kind::Signed;
+      i = value;
+    } else {
+      kind = Kind::Unsigned;
+      u = value;
+    }
+  }
+
+  Kind kind;
+  int64_t i = 0;
+  uint64_t u = 0;
+  long double f = 0;
+};
+
+// Condition on a field of the records of a structured array (or, with an
+// empty field name, on the elements of a plain array) for scan() and
+// friends. The operands are compared exactly with the values of the field's
+// type, e.g. an int32 field is never equal to 2.5.
+struct ScanPredicate {
+  enum class Op {
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Equal,
+    NotEqual,
+    Between, // operands[0] <= value <= operands[1]
+    In       // value equal to any of the operands
+  };
+
+  std::string field;
+  Op op;
+  std::vector<ScanOperand> operands;
+};
+
+// builds predicates, e.g. column("x") > 0.5 or column("id").in({1, 4, 9})
+class ScanColumn {
+public:
+  explicit ScanColumn(std::string name) : name{std::move(name)} {}
+
+  ScanPredicate operator<(ScanOperand v) const {
+    return {name, ScanPredicate::Op::Less, {v}};
+  }
+  ScanPredicate operator<=(ScanOperand v) const {
+    return {name, ScanPredicate::Op::LessEqual, {v}};
+  }
+  ScanPredicate operator>(ScanOperand v) const {
+    return {name, ScanPredicate::Op::Greater, {v}};
+  }
+  ScanPredicate operator>=(ScanOperand v) const {
+    return {name, ScanPredicate::Op::GreaterEqual, {v}};
+  }
+  ScanPredicate operator==(ScanOperand v) const {
+    return {name, ScanPredicate::Op::Equal, {v}};
+  }
+  ScanPredicate operator!=(ScanOperand v) const {
+    return {name, ScanPredicate::Op::NotEqual, {v}};
+  }
+
+  ScanPredicate between(ScanOperand lo, ScanOperand hi) const {
+    return {name, ScanPredicate::Op::Between, {lo, hi}};
+  }
+
+  template <typename TRange> ScanPredicate in(TRange const& values) const {
+    return {name, ScanPredicate::Op::In,
+            std::vector<ScanOperand>(std::begin(values), std::end(values))};
+  }
+
+  template <typename T>
+  ScanPredicate in(std::initializer_list<T> const values) const {
+    return in<std::initializer_list<T>>(values);
+  }
+
+private:
+  std::string name;
+};
+
+inline ScanColumn column(std::string name) {
+  return ScanColumn{std::move(name)};
+}
+
+// Selects the rows (elements in storage order) of array that satisfy all
+// predicates, as bitmap packed with BitOrder::Little. The predicates are
+// evaluated block-wise (with AVX2 if supported) on num_threads threads (0:
+// hardware concurrency).
+PackedBitArray scan(NpyArray const& array,
+                    std::vector<ScanPredicate> const& predicates,
+                    unsigned num_threads = 0);
+
+// like scan(), returning the indices of the selected rows
+std::vector<size_t> scan_indices(NpyArray const& array,
+                                 std::vector<ScanPredicate> const& predicates,
+                                 unsigned num_threads = 0);
+
+// like scan(), returning a copy of the selected rows as array of shape
+// (number of rows,) with the same fields
+NpyArray scan_select(NpyArray const& array,
+                     std::vector<ScanPredicate> const& predicates,
+                     unsigned num_threads = 0);
+
+// copies the array of the given shape from src, stored in memory order
+// src_order, to dst in the respective other memory order. The work is split
+// among num_threads threads (0: use hardware concurrency).
+void transpose_memory_order(std::byte const* src, std::byte* dst,
+                            cnpypp::span<size_t const> shape,
+                            size_t element_size, MemoryOrder src_order,
+                            unsigned num_threads = 0);
+
+// Permutes the axes of the array stored in in_fname like numpy.transpose(a,
+// axes) (empty axes: keep the order) and writes the result in memory order
+// out_order to out_fname. The data are processed out-of-core in tiles, using
+// about memory_budget bytes of buffer memory.
+void npy_relayout(std::string const& in_fname, std::string const& out_fname,
+                  cnpypp::span<size_t const> axes, MemoryOrder out_order,
+                  size_t memory_budget = size_t{1} << 30);
+
+// writes the array of the given shape from src, stored in memory order
+// src_order, to fs in the respective other memory order, slab by slab
+void write_data_transposed(std::byte const* src,
+                           cnpypp::span<size_t const> shape,
+                           size_t element_size, MemoryOrder src_order,
+                           std::ostream& fs);
+
 template <typename TConstInputIterator>
 bool constexpr is_contiguous_v =
 #if __cpp_lib_concepts >= 202002L
@@ -326,10 +1241,20 @@ void write_data(TConstInputIterator start, size_t nels, std::ostream& fs) {
            nels * size_elem / sizeof(std::ostream::char_type));
 }
 
-// otherwise do it in chunks with a buffer
 template <typename TConstInputIterator,
+          std::enable_if_t<is_contiguous_v<TConstInputIterator>, int> = 0>
+void write_data(TConstInputIterator start, size_t nels, Sink& sink) {
+  using value_type =
+      typename std::iterator_traits<TConstInputIterator>::value_type;
+
+  sink.write(reinterpret_cast<std::byte const*>(&*start),
+             nels * sizeof(value_type));
+}
+
+// otherwise do it in chunks with a buffer
+template <typename TConstInputIterator, typename TOutput,
           std::enable_if_t<!is_contiguous_v<TConstInputIterator>, int> = 0>
-void write_data(TConstInputIterator start, size_t nels, std::ostream& fs) {
+void write_data(TConstInputIterator start, size_t nels, TOutput& fs) {
   using value_type =
       typename std::iterator_traits<TConstInputIterator>::value_type;
 
@@ -352,6 +1277,64 @@ void write_data(TConstInputIterator start, size_t nels, std::ostream& fs) {
   }
 }
 
+// converts the n elements starting at it to TTarget into dst and returns the
+// iterator past them. Elements of non-contiguous ranges are staged in chunks
+// so that convert() is used in any case.
+template <typename TConstInputIterator, typename TTarget>
+TConstInputIterator convert_n(TConstInputIterator it, size_t n, TTarget* dst) {
+  using value_type =
+      typename std::iterator_traits<TConstInputIterator>::value_type;
+
+  if constexpr (std::is_same_v<value_type, TTarget>) {
+    for (size_t i = 0; i < n; ++i, ++it) {
+      dst[i] = *it;
+    }
+    return it;
+  } else if constexpr (is_contiguous_v<TConstInputIterator>) {
+    convert(&*it, n, dst);
+    return std::next(it, n);
+  } else if constexpr (is_fixed_string_v<TTarget>) {
+    // no staging copies of the strings
+    for (size_t i = 0; i < n; ++i, ++it) {
+      dst[i].assign(*it);
+    }
+    return it;
+  } else {
+    std::array<value_type, 256> staging;
+
+    for (size_t pos = 0; pos < n; pos += staging.size()) {
+      size_t const count = std::min(staging.size(), n - pos);
+      for (size_t i = 0; i < count; ++i, ++it) {
+        staging[i] = *it;
+      }
+      convert(staging.data(), count, dst + pos);
+    }
+    return it;
+  }
+}
+
+// convert to TTarget on the fly, chunk by chunk
+template <typename TConstInputIterator, typename TTarget, typename TOutput>
+void write_data(TConstInputIterator start, size_t nels, TOutput& fs,
+                save_as_t<TTarget>) {
+  using value_type =
+      typename std::iterator_traits<TConstInputIterator>::value_type;
+
+  if constexpr (std::is_same_v<value_type, TTarget>) {
+    write_data(start, nels, fs);
+  } else {
+    size_t const buffer_size = std::min(nels, 0x10000ul);
+    auto buffer = std::make_unique<TTarget[]>(buffer_size);
+    auto it = start;
+
+    for (size_t pos = 0; pos < nels; pos += buffer_size) {
+      size_t const count = std::min(buffer_size, nels - pos);
+      it = convert_n(it, count, buffer.get());
+      write_data(buffer.get(), count, fs);
+    }
+  }
+}
+
 template <typename T, int k = 0> void fill(T const& tup, char* buffer) {
   auto constexpr offsets = tuple_info<T>::offsets;
 
@@ -370,9 +1353,7 @@ template <typename T, int k = 0> void fill(T const& tup, char* buffer) {
 template <typename TTupleIterator>
 void write_data_tuple(TTupleIterator start, size_t nels, std::ostream& fs) {
   using value_type = typename std::iterator_traits<TTupleIterator>::value_type;
-  static auto constexpr sizes = tuple_info<value_type>::element_sizes;
   static auto constexpr sum = tuple_info<value_type>::sum_sizes;
-  static auto constexpr offsets = tuple_info<value_type>::offsets;
 
   size_t const buffer_size = std::min(nels, 0x10000ul); // number of tuples
 
@@ -412,17 +1393,32 @@ std::vector<char>& operator+=(std::vector<char>& lhs, const T rhs) {
 
 std::vector<char>& append(std::vector<char>&, std::string_view);
 
-template <typename TConstInputIterator>
-void npy_save(std::string const& fname, TConstInputIterator start,
-              cnpypp::span<size_t const> const shape,
-              std::string_view mode = "w",
-              MemoryOrder memory_order = MemoryOrder::C) {
+// like open_npy_for_writing<TValueType>() for structured arrays with the
+// given fields
+std::fstream open_npy_for_writing(std::string const& fname,
+                                  cnpypp::span<size_t const> shape,
+                                  cnpypp::span<std::string_view const> labels,
+                                  cnpypp::span<char const> dtypes,
+                                  cnpypp::span<size_t const> sizes,
+                                  cnpypp::span<std::vector<size_t> const>
+                                      field_shapes,
+                                  std::string_view mode,
+                                  MemoryOrder memory_order);
+
+// opens fname for writing (mode "w") or appending (mode "a") elements of type
+// TValueType and writes the (updated) header. The returned stream is
+// positioned at the end of the file.
+template <typename TValueType,
+          std::enable_if_t<!has_struct_info_v<TValueType>, int> = 0>
+std::fstream open_npy_for_writing(std::string const& fname,
+                                  cnpypp::span<size_t const> const shape,
+                                  std::string_view mode,
+                                  MemoryOrder memory_order) {
   std::fstream fs;
   std::vector<size_t>
       true_data_shape; // if appending, the shape of existing + new data
 
-  using value_type =
-      typename std::iterator_traits<TConstInputIterator>::value_type;
+  using value_type = TValueType;
 
   // forbid implementations of std::bool with sizeof(bool) != 1
   // numpy can't handle these
@@ -438,10 +1434,11 @@ void npy_save(std::string const& fname, TConstInputIterator start,
     std::vector<size_t> word_sizes_exist;
     std::vector<char> data_types_exist;
     std::vector<std::string> labels_exist;
+    std::vector<std::vector<size_t>> field_shapes_exist;
     cnpypp::MemoryOrder memory_order_exist;
 
     parse_npy_header(fs, word_sizes_exist, data_types_exist, labels_exist,
-                     true_data_shape, memory_order_exist);
+                     field_shapes_exist, true_data_shape, memory_order_exist);
 
     if (sizeof(value_type) != word_sizes_exist.at(0)) {
       throw std::runtime_error{
@@ -460,8 +1457,14 @@ void npy_save(std::string const& fname, TConstInputIterator start,
       throw std::runtime_error{"npy_save: ranks not matching"};
     }
 
-    if (!std::equal(std::next(shape.begin()), shape.end(),
-                    std::next(true_data_shape.begin()))) {
+    // data are appended along the slowest-varying axis
+    bool const shape_matches =
+        (memory_order == MemoryOrder::C)
+            ? std::equal(std::next(shape.begin()), shape.end(),
+                         std::next(true_data_shape.begin()))
+            : std::equal(shape.begin(), std::prev(shape.end()),
+                         true_data_shape.begin());
+    if (!shape_matches) {
       std::stringstream ss;
       ss << "libnpy error: npy_save attempting to append misshaped data to "
          << std::quoted(fname);
@@ -481,15 +1484,49 @@ void npy_save(std::string const& fname, TConstInputIterator start,
   std::vector<char> const header =
       create_npy_header(true_data_shape, map_type(value_type{}),
                         sizeof(value_type), memory_order);
-  size_t const nels =
-      std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<size_t>());
 
   fs.seekp(0, std::ios_base::beg);
   fs.write(&header[0], sizeof(char) * header.size());
   fs.seekp(0, std::ios_base::end);
 
+  return fs;
+}
+
+// same for structs registered with CNPYPP_STRUCT
+template <typename TValueType,
+          std::enable_if_t<has_struct_info_v<TValueType>, int> = 0>
+std::fstream open_npy_for_writing(std::string const& fname,
+                                  cnpypp::span<size_t const> const shape,
+                                  std::string_view mode,
+                                  MemoryOrder memory_order) {
+  auto const fields = struct_fields<TValueType>();
+  return open_npy_for_writing(fname, shape, fields.labels, fields.data_types,
+                              fields.word_sizes, fields.field_shapes, mode,
+                              memory_order);
+}
+
+template <typename TConstInputIterator, typename TTarget>
+void npy_save(std::string const& fname, TConstInputIterator start,
+              cnpypp::span<size_t const> const shape, save_as_t<TTarget>,
+              std::string_view mode = "w",
+              MemoryOrder memory_order = MemoryOrder::C) {
+  auto fs = open_npy_for_writing<TTarget>(fname, shape, mode, memory_order);
+  size_t const nels =
+      std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<size_t>());
+
   // now write actual data
-  write_data(start, nels, fs);
+  write_data(start, nels, fs, save_as_t<TTarget>{});
+}
+
+template <typename TConstInputIterator>
+void npy_save(std::string const& fname, TConstInputIterator start,
+              cnpypp::span<size_t const> const shape,
+              std::string_view mode = "w",
+              MemoryOrder memory_order = MemoryOrder::C) {
+  using value_type =
+      typename std::iterator_traits<TConstInputIterator>::value_type;
+
+  npy_save(fname, start, shape, save_as<value_type>, mode, memory_order);
 }
 
 template <typename TConstInputIterator>
@@ -502,6 +1539,328 @@ void npy_save(std::string const& fname, TConstInputIterator start,
       mode, memory_order);
 }
 
+template <typename TConstInputIterator, typename TTarget>
+void npy_save(std::string const& fname, TConstInputIterator start,
+              std::initializer_list<size_t> const shape,
+              save_as_t<TTarget> target, std::string_view mode = "w",
+              MemoryOrder memory_order = MemoryOrder::C) {
+  npy_save(fname, start,
+           cnpypp::span<size_t const>{std::data(shape), shape.size()}, target,
+           mode, memory_order);
+}
+
+// serializes header and data to sink. Contiguous data that need no
+// conversion are handed over together with the header in a single call.
+template <typename TConstInputIterator, typename TTarget>
+void npy_save(Sink& sink, TConstInputIterator start,
+              cnpypp::span<size_t const> const shape, save_as_t<TTarget>,
+              MemoryOrder memory_order = MemoryOrder::C) {
+  using value_type =
+      typename std::iterator_traits<TConstInputIterator>::value_type;
+
+  std::vector<char> const header =
+      create_npy_header<TTarget>(shape, memory_order);
+  size_t const nels = std::accumulate(shape.begin(), shape.end(), size_t{1},
+                                      std::multiplies<size_t>());
+
+  sink.reserve(header.size() + nels * sizeof(TTarget));
+
+  if constexpr (std::is_same_v<value_type, TTarget> &&
+                is_contiguous_v<TConstInputIterator>) {
+    sink.write(reinterpret_cast<std::byte const*>(header.data()),
+               header.size(), reinterpret_cast<std::byte const*>(&*start),
+               nels * sizeof(TTarget));
+  } else {
+    sink.write(reinterpret_cast<std::byte const*>(header.data()),
+               header.size());
+    write_data(start, nels, sink, save_as_t<TTarget>{});
+  }
+}
+
+template <typename TConstInputIterator>
+void npy_save(Sink& sink, TConstInputIterator start,
+              cnpypp::span<size_t const> const shape,
+              MemoryOrder memory_order = MemoryOrder::C) {
+  using value_type =
+      typename std::iterator_traits<TConstInputIterator>::value_type;
+
+  npy_save(sink, start, shape, save_as<value_type>, memory_order);
+}
+
+template <typename TConstInputIterator>
+void npy_save(Sink& sink, TConstInputIterator start,
+              std::initializer_list<size_t> const shape,
+              MemoryOrder memory_order = MemoryOrder::C) {
+  npy_save<TConstInputIterator>(
+      sink, start, cnpypp::span<size_t const>{std::data(shape), shape.size()},
+      memory_order);
+}
+
+template <typename TConstInputIterator, typename TTarget>
+void npy_save(Sink& sink, TConstInputIterator start,
+              std::initializer_list<size_t> const shape,
+              save_as_t<TTarget> target,
+              MemoryOrder memory_order = MemoryOrder::C) {
+  npy_save(sink, start,
+           cnpypp::span<size_t const>{std::data(shape), shape.size()}, target,
+           memory_order);
+}
+
+// writes header and payload to the file fname, which is truncated and
+// preallocated, with num_threads (0: hardware concurrency) threads issuing
+// pwrite() calls on disjoint chunks of the payload. Without CNPYPP_POSIX the
+// data are written sequentially.
+void write_parallel(std::string const& fname, std::vector<char> const& header,
+                    std::byte const* payload, size_t payload_size,
+                    unsigned num_threads = 0);
+
+#ifdef CNPYPP_POSIX
+// Handle for filling a preallocated C-order .npy file in blocks of rows
+// (i.e. ranges of the first axis). write_rows() uses positioned writes and
+// may be called concurrently from several threads; other processes can
+// open the same file and write disjoint rows at the same time.
+class NpyRowWriter {
+public:
+  // opens a file previously created with npy_create()
+  NpyRowWriter(std::string const& fname);
+  NpyRowWriter(NpyRowWriter&& other);
+  NpyRowWriter(NpyRowWriter const&) = delete;
+  ~NpyRowWriter();
+
+  // writes num_rows rows from data starting at row begin_row
+  void write_rows(size_t begin_row, std::byte const* data,
+                  size_t num_rows) const;
+
+  template <typename T>
+  void write_rows(size_t begin_row, cnpypp::span<T const> data) const {
+    size_t const num_bytes = data.size() * sizeof(T);
+
+    if (row_size == 0 || num_bytes % row_size != 0) {
+      throw std::runtime_error(
+          "write_rows: data size is not a multiple of the row size");
+    }
+
+    write_rows(begin_row, reinterpret_cast<std::byte const*>(data.data()),
+               num_bytes / row_size);
+  }
+
+  size_t rows() const { return num_rows; }
+  size_t row_bytes() const { return row_size; }
+
+private:
+  NpyRowWriter(int fd, size_t data_offset, size_t num_rows, size_t row_size);
+
+  friend NpyRowWriter npy_create(std::string const&,
+                                 cnpypp::span<size_t const>, char, size_t);
+
+  int fd;
+  size_t data_offset;
+  size_t num_rows;
+  size_t row_size;
+};
+
+// creates fname with a header for a C-order array of the given shape and
+// element type (descriptor character and size in bytes as in map_type()),
+// preallocates the data region and returns a writer for it
+NpyRowWriter npy_create(std::string const& fname,
+                        cnpypp::span<size_t const> shape, char data_type,
+                        size_t word_size);
+
+template <typename T>
+NpyRowWriter npy_create(std::string const& fname,
+                        cnpypp::span<size_t const> shape) {
+  return npy_create(fname, shape, map_type(T{}), sizeof(T));
+}
+
+template <typename T>
+NpyRowWriter npy_create(std::string const& fname,
+                        std::initializer_list<size_t> const shape) {
+  return npy_create<T>(
+      fname, cnpypp::span<size_t const>{std::data(shape), shape.size()});
+}
+
+// Appends rows (each of shape row_shape) to a new C-order .npy file from
+// many threads concurrently. append() reserves its range of rows with an
+// atomic counter and writes them with pwrite() without any locking. The
+// shape in the header, which is written with slack so that it never changes
+// its length, is advanced by one thread at a time up to the end of the
+// longest complete prefix of rows; readers hence never see rows that have
+// not been written yet. The destructor commits all rows.
+class NpyAppender {
+public:
+  NpyAppender(std::string const& fname, cnpypp::span<size_t const> row_shape,
+              char data_type, size_t word_size);
+  NpyAppender(NpyAppender&&);
+  NpyAppender(NpyAppender const&) = delete;
+  ~NpyAppender();
+
+  // returns the index of the first appended row
+  size_t append(std::byte const* data, size_t num_rows);
+
+  template <typename T> size_t append(cnpypp::span<T const> data) {
+    size_t const num_bytes = data.size() * sizeof(T);
+
+    if (row_bytes() == 0 || num_bytes % row_bytes() != 0) {
+      throw std::runtime_error(
+          "append: data size is not a multiple of the row size");
+    }
+
+    return append(reinterpret_cast<std::byte const*>(data.data()),
+                  num_bytes / row_bytes());
+  }
+
+  // updates the header with all rows completed so far; returns the number
+  // of rows recorded in the header
+  size_t commit();
+
+  size_t row_bytes() const;
+
+private:
+  struct State;
+  std::unique_ptr<State> state;
+};
+
+template <typename T>
+NpyAppender npy_appender(std::string const& fname,
+                         cnpypp::span<size_t const> row_shape) {
+  return NpyAppender{fname, row_shape, map_type(T{}), sizeof(T)};
+}
+
+template <typename T>
+NpyAppender npy_appender(std::string const& fname,
+                         std::initializer_list<size_t> const row_shape) {
+  return npy_appender<T>(fname, cnpypp::span<size_t const>{
+                                    std::data(row_shape), row_shape.size()});
+}
+
+// C-order array in a new file that grows along its first axis while being
+// accessed through a shared memory mapping. A range of max_bytes (0: a
+// platform-dependent default of 1 TiB on 64-bit systems) of address space
+// is reserved up-front; the file is extended geometrically and remapped
+// into this range, so that pointers obtained from data() stay valid. The
+// header is written with slack and its shape is updated in place. Not
+// thread-safe. The destructor truncates the file to the used size.
+class NpyGrowableArray {
+public:
+  NpyGrowableArray(std::string const& fname,
+                   cnpypp::span<size_t const> row_shape, char data_type,
+                   size_t word_size, size_t max_bytes = 0);
+  NpyGrowableArray(NpyGrowableArray&& other);
+  NpyGrowableArray(NpyGrowableArray const&) = delete;
+  ~NpyGrowableArray();
+
+  // appends num_rows rows from data
+  void append(std::byte const* data, size_t num_rows);
+
+  template <typename T> void append(cnpypp::span<T const> data) {
+    size_t const num_bytes = data.size() * sizeof(T);
+
+    if (row_size == 0 || num_bytes % row_size != 0) {
+      throw std::runtime_error(
+          "append: data size is not a multiple of the row size");
+    }
+
+    append(reinterpret_cast<std::byte const*>(data.data()),
+           num_bytes / row_size);
+  }
+
+  // changes the number of rows; new rows are zero-initialized
+  void resize(size_t num_rows);
+
+  template <typename T> T* data() {
+    return reinterpret_cast<T*>(base + header_size);
+  }
+
+  template <typename T> T const* data() const {
+    return reinterpret_cast<T const*>(base + header_size);
+  }
+
+  std::vector<size_t> const& shape() const { return array_shape; }
+  size_t rows() const { return array_shape[0]; }
+  size_t row_bytes() const { return row_size; }
+
+  // msync()s the header and the data
+  void sync();
+
+private:
+  void reserve(size_t num_rows);
+  void write_header();
+
+  int fd;
+  std::byte* base;     // start of the reserved address range
+  size_t reserved;     // size of the reserved address range
+  size_t mapped;       // bytes of the file currently mapped at base
+  size_t header_size;  // including slack
+  std::vector<size_t> array_shape;
+  char data_type;
+  size_t word_size;
+  size_t row_size;
+};
+
+template <typename T>
+NpyGrowableArray npy_create_growable(std::string const& fname,
+                                     cnpypp::span<size_t const> row_shape,
+                                     size_t max_bytes = 0) {
+  return NpyGrowableArray{fname, row_shape, map_type(T{}), sizeof(T),
+                          max_bytes};
+}
+
+template <typename T>
+NpyGrowableArray
+npy_create_growable(std::string const& fname,
+                    std::initializer_list<size_t> const row_shape,
+                    size_t max_bytes = 0) {
+  return npy_create_growable<T>(
+      fname,
+      cnpypp::span<size_t const>{std::data(row_shape), row_shape.size()},
+      max_bytes);
+}
+#endif
+
+// like npy_save(fname, data, shape), but the contiguous data are written
+// with multiple threads in parallel. Appending is not supported.
+template <typename T>
+void npy_save_parallel(std::string const& fname, T const* data,
+                       cnpypp::span<size_t const> const shape,
+                       MemoryOrder memory_order = MemoryOrder::C,
+                       unsigned num_threads = 0) {
+  size_t const nels = std::accumulate(shape.begin(), shape.end(), size_t{1},
+                                      std::multiplies<size_t>());
+
+  write_parallel(fname,
+                 create_npy_header(shape, map_type(T{}), sizeof(T),
+                                   memory_order),
+                 reinterpret_cast<std::byte const*>(data), nels * sizeof(T),
+                 num_threads);
+}
+
+template <typename T>
+void npy_save_parallel(std::string const& fname, T const* data,
+                       std::initializer_list<size_t> const shape,
+                       MemoryOrder memory_order = MemoryOrder::C,
+                       unsigned num_threads = 0) {
+  npy_save_parallel(fname, data,
+                    cnpypp::span<size_t const>{std::data(shape), shape.size()},
+                    memory_order, num_threads);
+}
+
+// data stored in memory_order are written to the file in file_order
+template <typename T>
+void npy_save(std::string const& fname, T const* data,
+              cnpypp::span<size_t const> const shape, std::string_view mode,
+              MemoryOrder memory_order, MemoryOrder file_order) {
+  auto fs = open_npy_for_writing<T>(fname, shape, mode, file_order);
+
+  if (memory_order == file_order) {
+    size_t const nels = std::accumulate(shape.begin(), shape.end(), size_t{1},
+                                        std::multiplies<size_t>());
+    write_data(data, nels, fs);
+  } else {
+    write_data_transposed(reinterpret_cast<std::byte const*>(data), shape,
+                          sizeof(T), memory_order, fs);
+  }
+}
+
 #ifndef NO_LIBZIP
 std::tuple<size_t, zip_t*> prepare_npz(std::string const& zipname,
                                        cnpypp::span<size_t const> const shape,
@@ -513,13 +1872,12 @@ void finalize_npz(zip_t*, std::string, detail::additional_parameters&);
 #endif
 
 #ifndef NO_LIBZIP
-template <typename TConstInputIterator>
+template <typename TConstInputIterator, typename TTarget>
 void npz_save(std::string const& zipname, std::string const& fname,
               TConstInputIterator start, cnpypp::span<size_t const> const shape,
-              std::string_view mode = "w",
+              save_as_t<TTarget>, std::string_view mode = "w",
               MemoryOrder memory_order = MemoryOrder::C) {
-  using value_type =
-      typename std::iterator_traits<TConstInputIterator>::value_type;
+  using value_type = TTarget; // type of the elements on disk
   size_t constexpr wordsize = sizeof(value_type);
 
   // forbid implementations of std::bool with sizeof(bool) != 1
@@ -540,10 +1898,7 @@ void npz_save(std::string const& zipname, std::string const& fname,
     value_type* libzip_word_buffer =
         reinterpret_cast<value_type*>(libzip_buffer.data());
 
-    for (size_t i = 0; i < n_tbw; ++i) {
-      libzip_word_buffer[i] = *(it++);
-    }
-
+    it = convert_n(it, n_tbw, libzip_word_buffer);
     elements_written_total += n_tbw;
 
     if (elements_written_total < nels &&
@@ -551,7 +1906,7 @@ void npz_save(std::string const& zipname, std::string const& fname,
       // some space left that could not be filled with a single element
       // write one into temp. buffer
       auto* const tmp = reinterpret_cast<value_type*>(&parameters->buffer[0]);
-      *tmp = *(it++);
+      it = convert_n(it, 1, tmp);
       parameters->buffer_size = wordsize;
 
       ++elements_written_total;
@@ -561,13 +1916,26 @@ void npz_save(std::string const& zipname, std::string const& fname,
   };
 
   detail::additional_parameters parameters{
-      create_npy_header(shape, map_type(value_type{}), wordsize, memory_order),
-      wordsize, callback};
+      create_npy_header<value_type>(shape, memory_order), wordsize, callback};
 
   finalize_npz(archive, fname, parameters);
 }
 #endif
 
+#ifndef NO_LIBZIP
+template <typename TConstInputIterator>
+void npz_save(std::string const& zipname, std::string const& fname,
+              TConstInputIterator start, cnpypp::span<size_t const> const shape,
+              std::string_view mode = "w",
+              MemoryOrder memory_order = MemoryOrder::C) {
+  using value_type =
+      typename std::iterator_traits<TConstInputIterator>::value_type;
+
+  npz_save(zipname, fname, start, shape, save_as<value_type>, mode,
+           memory_order);
+}
+#endif
+
 #ifndef NO_LIBZIP
 template <typename TTupleIterator>
 void npz_save(std::string const& zipname, std::string const& fname,
@@ -629,8 +1997,9 @@ void npz_save(std::string const& zipname, std::string const& fname,
   };
 
   detail::additional_parameters parameters{
-      create_npy_header(shape, labels, dtypes, sizes, memory_order), sum_size,
-      callback};
+      create_npy_header(shape, labels, dtypes, sizes,
+                        tuple_info<value_type>::field_shapes(), memory_order),
+      sum_size, callback};
 
   finalize_npz(archive, fname, parameters);
 }
@@ -649,6 +2018,19 @@ void npz_save(std::string const& zipname, std::string fname,
 }
 #endif
 
+#ifndef NO_LIBZIP
+template <typename TConstInputIterator, typename TTarget>
+void npz_save(std::string const& zipname, std::string fname,
+              TConstInputIterator start,
+              std::initializer_list<size_t const> shape,
+              save_as_t<TTarget> target, std::string_view mode = "w",
+              MemoryOrder memory_order = MemoryOrder::C) {
+  npz_save(zipname, std::move(fname), start,
+           cnpypp::span<size_t const>{std::data(shape), shape.size()}, target,
+           mode, memory_order);
+}
+#endif
+
 template <typename TForwardIterator>
 void npy_save(std::string const& fname, TForwardIterator first,
               TForwardIterator last, std::string_view mode = "w") {
@@ -688,80 +2070,13 @@ void npy_save(std::string const& fname,
   auto constexpr& dtypes = tuple_info<value_type>::data_types;
   auto constexpr& sizes = tuple_info<value_type>::element_sizes;
 
-  std::fstream fs;
-  std::vector<size_t>
-      true_data_shape; // if appending, the shape of existing + new data
-
-  if (mode == "a" && _exists(fname)) {
-    // file exists. we need to append to it. read the header, modify the array
-    // size
-    fs.open(fname,
-            std::ios_base::binary | std::ios_base::in | std::ios_base::out);
-
-    std::vector<size_t> word_sizes_exist, shape;
-    std::vector<char> data_types_exist;
-    std::vector<std::string> labels_exist;
-    cnpypp::MemoryOrder memory_order_exist;
-
-    parse_npy_header(fs, word_sizes_exist, data_types_exist, labels_exist,
-                     true_data_shape, memory_order_exist);
-
-    if (tuple_info<value_type>::size != labels_exist.size()) {
-      throw std::runtime_error{"libcnpy++ error in npy_save(): appending "
-                               "failed: sizes not matching"};
-    }
-    if (!std::equal(data_types_exist.cbegin(), data_types_exist.cend(),
-                    dtypes.cbegin())) {
-      throw std::runtime_error{"libcnpy++ error in npy_save(): appending "
-                               "failed: data type descriptors not matching"};
-    }
-    if (!std::equal(word_sizes_exist.cbegin(), word_sizes_exist.cend(),
-                    sizes.cbegin())) {
-      throw std::runtime_error{"libcnpy++ error in npy_save(): appending "
-                               "failed: element sizes not matching"};
-    }
-
-    if (memory_order != memory_order_exist) {
-      throw std::runtime_error{
-          "libcnpy++ error in npy_save(): memory order does not match"};
-    }
-
-    if (true_data_shape.size() != shape.size()) {
-      std::stringstream ss;
-      ss << "libcnpy++ error: npy_save attempting to append misdimensioned "
-            "data to "
-         << std::quoted(fname);
-      throw std::runtime_error{ss.str().c_str()};
-    }
-
-    if (shape.size() > 0 && !std::equal(std::next(shape.begin()), shape.end(),
-                                        std::next(true_data_shape.begin()))) {
-      std::stringstream ss;
-      ss << "libcnpy++ error: npy_save attempting to append misshaped data to "
-         << std::quoted(fname);
-      throw std::runtime_error{ss.str().c_str()};
-    }
-
-    if (memory_order == MemoryOrder::C)
-      true_data_shape.front() += shape.front();
-    else
-      true_data_shape.back() += shape.back();
-
-  } else { // write mode
-    fs.open(fname, std::ios_base::binary | std::ios_base::out);
-    true_data_shape = std::vector<size_t>{shape.begin(), shape.end()};
-  }
-
-  auto const header =
-      create_npy_header(shape, labels, dtypes, sizes, memory_order);
+  auto fs = open_npy_for_writing(fname, shape, labels, dtypes, sizes,
+                                 tuple_info<value_type>::field_shapes(), mode,
+                                 memory_order);
 
   size_t const nels =
       std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<size_t>());
 
-  fs.seekp(0, std::ios_base::beg);
-  fs.write(&header[0], sizeof(char) * header.size());
-  fs.seekp(0, std::ios_base::end);
-
   // now write actual data
   write_data_tuple(first, nels, fs);
 }
@@ -0,0 +1,115 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include <boost/stl_interfaces/iterator_interface.hpp>
+
+namespace cnpypp {
+
+// order of the bits within each byte as in np.packbits(..., bitorder=...):
+// Big (NumPy's default) stores the first element in the most significant bit
+enum class BitOrder { Big, Little };
+
+// bulk kernels for bit-packed boolean data, SIMD-accelerated if supported by
+// the CPU (AVX2, POPCNT). n is the number of bits, stored in (n + 7) / 8
+// bytes; unused bits of the last byte are written as zero and ignored when
+// reading.
+void pack_bits(bool const* src, size_t n, uint8_t* dst,
+               BitOrder order = BitOrder::Big);
+void unpack_bits(uint8_t const* src, size_t n, bool* dst,
+                 BitOrder order = BitOrder::Big);
+
+size_t count_bits(uint8_t const* bits, size_t n,
+                  BitOrder order = BitOrder::Big); // number of set bits
+bool any_bits(uint8_t const* bits, size_t n, BitOrder order = BitOrder::Big);
+bool all_bits(uint8_t const* bits, size_t n, BitOrder order = BitOrder::Big);
+
+namespace detail {
+inline bool test_bit(uint8_t const* bits, size_t i, BitOrder order) {
+  unsigned const shift = (order == BitOrder::Big) ? 7 - i % 8 : i % 8;
+  return (bits[i / 8] >> shift) & 1;
+}
+
+// mask of the valid bits in the last byte of n bits
+inline uint8_t tail_mask(size_t n, BitOrder order) {
+  unsigned const valid = n % 8;
+  if (valid == 0) {
+    return 0xff;
+  }
+  return (order == BitOrder::Big) ? static_cast<uint8_t>(0xff00 >> valid)
+                                  : static_cast<uint8_t>((1u << valid) - 1);
+}
+} // namespace detail
+
+class bit_iterator
+    : public boost::stl_interfaces::proxy_iterator_interface<
+          bit_iterator, std::random_access_iterator_tag, bool> {
+public:
+  bit_iterator(uint8_t const* bits, size_t index, BitOrder order)
+      : bits_{bits}, index_{index}, order_{order} {}
+  bit_iterator() : bits_{nullptr}, index_{}, order_{BitOrder::Big} {}
+
+  bool operator*() const { return detail::test_bit(bits_, index_, order_); }
+
+  bit_iterator& operator+=(std::ptrdiff_t n) {
+    index_ += n;
+    return *this;
+  }
+
+  bool operator==(bit_iterator const& other) const {
+    return index_ == other.index_;
+  }
+
+  std::ptrdiff_t operator-(bit_iterator const& other) const {
+    return static_cast<std::ptrdiff_t>(index_) -
+           static_cast<std::ptrdiff_t>(other.index_);
+  }
+
+private:
+  uint8_t const* bits_;
+  size_t index_;
+  BitOrder order_;
+};
+
+// Non-owning read-only view onto size bits packed as by np.packbits(). The
+// reductions work on the packed bytes directly.
+class bit_view {
+public:
+  bit_view(uint8_t const* bits, size_t size, BitOrder order = BitOrder::Big)
+      : bits_{bits}, size_{size}, order_{order} {}
+
+  uint8_t const* data() const { return bits_; }
+  size_t size() const { return size_; }
+  size_t num_bytes() const { return (size_ + 7) / 8; }
+  bool empty() const { return size_ == 0; }
+  BitOrder order() const { return order_; }
+
+  bool operator[](size_t i) const { return detail::test_bit(bits_, i, order_); }
+
+  bit_iterator begin() const { return bit_iterator{bits_, 0, order_}; }
+  bit_iterator end() const { return bit_iterator{bits_, size_, order_}; }
+
+  size_t count() const { return count_bits(bits_, size_, order_); }
+  bool any() const { return any_bits(bits_, size_, order_); }
+  bool all() const { return all_bits(bits_, size_, order_); }
+
+  // writes the bits [first, first + n) as bools to dst; first has to be a
+  // multiple of 8
+  void unpack(size_t first, size_t n, bool* dst) const {
+    unpack_bits(bits_ + first / 8, n, dst, order_);
+  }
+
+private:
+  uint8_t const* bits_;
+  size_t size_;
+  BitOrder order_;
+};
+
+} // namespace cnpypp
@@ -6,13 +6,36 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
 
 #include <boost/iostreams/device/mapped_file.hpp>
 
+#include <cnpy++/platform.hpp>
+
 namespace cnpypp {
+// access pattern hints for memory-mapped arrays, can be combined with |.
+// Without CNPYPP_POSIX (no madvise()) only populate has an effect.
+enum class MapHint : unsigned {
+  none = 0,
+  sequential = 1u << 0, // aggressive readahead
+  random = 1u << 1,     // no readahead
+  willneed = 1u << 2,   // start reading all data asynchronously
+  populate = 1u << 3,   // read all data before returning
+  hugepages = 1u << 4,  // transparent huge pages (e.g. for files on tmpfs)
+};
+
+constexpr MapHint operator|(MapHint a, MapHint b) {
+  return static_cast<MapHint>(static_cast<unsigned>(a) |
+                              static_cast<unsigned>(b));
+}
+
+constexpr bool has_hint(MapHint hints, MapHint h) {
+  return (static_cast<unsigned>(hints) & static_cast<unsigned>(h)) != 0;
+}
+
 class Buffer {
 protected:
   Buffer() = default;
@@ -21,6 +44,14 @@ public:
   virtual ~Buffer() = default;
   virtual std::byte* data() = 0;
   virtual std::byte const* data() const = 0;
+
+  // writes modified data back to persistent storage, if applicable
+  virtual void sync() {}
+
+  // hint that the given byte range of data() is going to be accessed soon or
+  // not any time soon, respectively; only meaningful for mapped buffers
+  virtual void prefetch(size_t /* offset */, size_t /* length */) {}
+  virtual void evict(size_t /* offset */, size_t /* length */) {}
 };
 
 class InMemoryBuffer : public Buffer {
@@ -37,9 +68,27 @@ private:
   std::unique_ptr<std::byte[]> buffer;
 };
 
+// refers to memory owned by someone else; the optional release function is
+// called on destruction, e.g. to free the memory
+class ExternalBuffer : public Buffer {
+public:
+  ExternalBuffer(std::byte* data, std::function<void()> release = {});
+  ExternalBuffer(ExternalBuffer const&) = delete;
+  ExternalBuffer(ExternalBuffer&&) = default;
+  ~ExternalBuffer();
+
+  virtual std::byte* data() override;
+  virtual std::byte const* data() const override;
+
+private:
+  std::byte* const buffer;
+  std::function<void()> release;
+};
+
 class MemoryMappedBuffer : public Buffer {
 public:
-  MemoryMappedBuffer(std::string const& path, size_t offset, size_t length);
+  MemoryMappedBuffer(std::string const& path, size_t offset, size_t length,
+                     MapHint hints = MapHint::none);
   MemoryMappedBuffer(MemoryMappedBuffer const&) = delete;
   MemoryMappedBuffer(MemoryMappedBuffer&&) = default;
   ~MemoryMappedBuffer() = default;
@@ -47,8 +96,50 @@ public:
   virtual std::byte* data() override;
   virtual std::byte const* data() const override;
 
+  // madvise(MADV_WILLNEED) and madvise(MADV_DONTNEED); as the mapping is
+  // private, evict() discards modifications made to the range
+  virtual void prefetch(size_t offset, size_t length) override;
+  virtual void evict(size_t offset, size_t length) override;
+
 private:
   size_t const offset;
   boost::iostreams::mapped_file buffer;
 };
+
+// shared read-write mapping of a file region: modifications go directly to
+// the page cache and thus end up in the file
+class WritableMemoryMappedBuffer : public Buffer {
+public:
+  WritableMemoryMappedBuffer(std::string const& path, size_t offset,
+                             size_t length);
+
+#ifdef CNPYPP_POSIX
+  // maps from an open file descriptor, which may be closed afterwards
+  WritableMemoryMappedBuffer(int fd, size_t offset, size_t length);
+#endif
+  WritableMemoryMappedBuffer(WritableMemoryMappedBuffer const&) = delete;
+  ~WritableMemoryMappedBuffer();
+
+  virtual std::byte* data() override;
+  virtual std::byte const* data() const override;
+
+  // msync()s the mapping; a no-op without CNPYPP_POSIX, where modifications
+  // are written back when the mapping is closed
+  virtual void sync() override;
+
+  virtual void prefetch(size_t offset, size_t length) override;
+  virtual void evict(size_t offset, size_t length) override;
+
+private:
+#ifdef CNPYPP_POSIX
+  void map(int fd, size_t aligned_offset);
+
+  size_t const offset;
+  size_t const length;
+  void* mapping;
+#else
+  size_t const offset;
+  boost::iostreams::mapped_file buffer;
+#endif
+};
 } // namespace cnpypp
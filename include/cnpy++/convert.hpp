@@ -0,0 +1,44 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+#include <cnpy++/half.hpp>
+
+namespace cnpypp {
+
+//! tag type to request conversion to element type T when saving
+template <typename T> struct save_as_t { using type = T; };
+
+template <typename T> inline constexpr save_as_t<T> save_as{};
+
+// bulk conversion kernels, SIMD-accelerated if supported by the CPU
+// (AVX/AVX-512 for double -> float, F16C/AVX-512-FP16 for float16,
+// AVX2 for bfloat16)
+void convert(double const* src, size_t n, float* dst);
+void convert(float const* src, size_t n, float16* dst);
+void convert(double const* src, size_t n, float16* dst);
+void convert(float16 const* src, size_t n, float* dst);
+void convert(float const* src, size_t n, bfloat16* dst);
+void convert(double const* src, size_t n, bfloat16* dst);
+void convert(bfloat16 const* src, size_t n, float* dst);
+
+// generic element-wise fallback
+template <typename TFrom, typename TTo>
+void convert(TFrom const* src, size_t n, TTo* dst) {
+  std::transform(src, src + n, dst, [](TFrom const& v) {
+    if constexpr (std::is_arithmetic_v<TFrom> || std::is_arithmetic_v<TTo>) {
+      return static_cast<TTo>(v);
+    } else { // between half-precision types
+      return static_cast<TTo>(static_cast<float>(v));
+    }
+  });
+}
+
+} // namespace cnpypp
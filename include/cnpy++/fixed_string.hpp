@@ -0,0 +1,132 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+
+#include <boost/stl_interfaces/iterator_interface.hpp>
+
+namespace cnpypp {
+
+namespace detail {
+template <typename TChar> char constexpr string_data_type() {
+  static_assert(std::is_same_v<TChar, char> || std::is_same_v<TChar, char32_t>,
+                "only char ('S') and char32_t ('U') supported");
+  return std::is_same_v<TChar, char> ? 'S' : 'U';
+}
+
+// NumPy strips trailing NULs of fixed-width strings
+template <typename TChar>
+std::basic_string_view<TChar> trim_nul(TChar const* chars, size_t width) {
+  while (width > 0 && chars[width - 1] == TChar{}) {
+    --width;
+  }
+  return {chars, width};
+}
+} // namespace detail
+
+// Fixed-width string of N characters as stored in the elements or fields of
+// 'S' (TChar = char, bytes) and 'U' (TChar = char32_t, UCS-4) arrays.
+// Shorter strings are padded with NULs, longer ones are truncated.
+template <size_t N, typename TChar = char> struct fixed_string {
+  static_assert(N > 0, "empty strings not supported");
+
+  std::array<TChar, N> chars{};
+
+  fixed_string() = default;
+
+  // from anything convertible to std::basic_string_view<TChar>, e.g.
+  // std::string or string literals
+  template <typename TString,
+            std::enable_if_t<std::is_convertible_v<
+                                 TString const&, std::basic_string_view<TChar>>,
+                             int> = 0>
+  fixed_string(TString const& str) {
+    assign(str);
+  }
+
+  void assign(std::basic_string_view<TChar> str) {
+    auto const end = std::copy_n(str.data(), std::min(str.size(), N),
+                                 chars.begin());
+    std::fill(end, chars.end(), TChar{});
+  }
+
+  std::basic_string_view<TChar> view() const {
+    return detail::trim_nul(chars.data(), N);
+  }
+
+  operator std::basic_string_view<TChar>() const { return view(); }
+};
+
+template <size_t N> using fixed_u32string = fixed_string<N, char32_t>;
+
+namespace detail {
+template <typename T> struct is_fixed_string : std::false_type {};
+
+template <size_t N, typename TChar>
+struct is_fixed_string<fixed_string<N, TChar>> : std::true_type {};
+} // namespace detail
+
+template <typename T>
+bool constexpr is_fixed_string_v = detail::is_fixed_string<T>::value;
+
+template <size_t N, typename TChar>
+char constexpr map_type(fixed_string<N, TChar>) {
+  return detail::string_data_type<TChar>();
+}
+
+// pads or truncates n strings (e.g. std::string or std::string_view) from
+// src into dst, used with save_as<fixed_string<N>>
+template <typename TFrom, size_t N, typename TChar>
+void convert(TFrom const* src, size_t n, fixed_string<N, TChar>* dst) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i].assign(src[i]);
+  }
+}
+
+// Iterates over fixed-width strings of width characters that are stride
+// bytes apart, yielding views without trailing NULs onto the underlying
+// memory.
+template <typename TChar>
+class fixed_string_iterator
+    : public boost::stl_interfaces::proxy_iterator_interface<
+          fixed_string_iterator<TChar>, std::random_access_iterator_tag,
+          std::basic_string_view<TChar>> {
+public:
+  fixed_string_iterator(std::byte const* ptr, size_t width,
+                        std::ptrdiff_t stride)
+      : ptr_{ptr}, width_{width}, stride_{stride} {}
+  fixed_string_iterator() : ptr_{nullptr}, width_{}, stride_{} {}
+
+  std::basic_string_view<TChar> operator*() const {
+    return detail::trim_nul(reinterpret_cast<TChar const*>(ptr_), width_);
+  }
+
+  fixed_string_iterator& operator+=(std::ptrdiff_t n) {
+    ptr_ += n * stride_;
+    return *this;
+  }
+
+  bool operator==(fixed_string_iterator const& other) const {
+    return ptr_ == other.ptr_;
+  }
+
+  std::ptrdiff_t operator-(fixed_string_iterator const& other) const {
+    return (ptr_ - other.ptr_) / stride_;
+  }
+
+private:
+  std::byte const* ptr_;
+  size_t width_;
+  std::ptrdiff_t stride_;
+};
+
+} // namespace cnpypp
@@ -0,0 +1,171 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace cnpypp {
+
+namespace detail {
+inline uint32_t float_to_bits(float f) {
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  return bits;
+}
+
+inline float bits_to_float(uint32_t bits) {
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+// IEEE 754 binary32 -> binary16, round to nearest even
+inline uint16_t float_bits_to_half(uint32_t x) {
+  uint32_t const sign = (x >> 16) & 0x8000;
+  uint32_t const absx = x & 0x7fffffff;
+
+  if (absx >= 0x7f800000) { // inf or NaN (keep NaN quiet)
+    return sign | 0x7c00 |
+           ((absx > 0x7f800000) ? (0x200 | ((absx >> 13) & 0x3ff)) : 0);
+  } else if (absx >= 0x477ff000) { // >= 65520 rounds to inf
+    return sign | 0x7c00;
+  } else if (absx < 0x38800000) { // subnormal half or zero
+    if (absx <= 0x33000000) {
+      return sign;
+    }
+
+    uint32_t const mant = (absx & 0x7fffff) | 0x800000;
+    uint32_t const shift = 126 - (absx >> 23);
+    uint32_t h = mant >> shift;
+    uint32_t const rem = mant & ((1u << shift) - 1);
+    uint32_t const halfway = 1u << (shift - 1);
+    if (rem > halfway || (rem == halfway && (h & 1))) {
+      ++h;
+    }
+    return sign | h;
+  } else {
+    uint32_t h = (absx - 0x38000000) >> 13;
+    uint32_t const rem = absx & 0x1fff;
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) {
+      ++h;
+    }
+    return sign | h;
+  }
+}
+
+inline uint32_t half_to_float_bits(uint16_t h) {
+  uint32_t const sign = uint32_t(h & 0x8000) << 16;
+  uint32_t const exp = (h >> 10) & 0x1f;
+  uint32_t mant = h & 0x3ff;
+
+  if (exp == 0x1f) {
+    return sign | 0x7f800000 | (mant << 13);
+  } else if (exp == 0) {
+    if (mant == 0) {
+      return sign;
+    }
+
+    uint32_t e = 113;
+    while (!(mant & 0x400)) {
+      mant <<= 1;
+      --e;
+    }
+    return sign | (e << 23) | ((mant & 0x3ff) << 13);
+  } else {
+    return sign | ((exp + 112) << 23) | (mant << 13);
+  }
+}
+
+// IEEE 754 binary32 -> bfloat16, round to nearest even
+inline uint16_t float_bits_to_bfloat(uint32_t x) {
+  if ((x & 0x7fffffff) > 0x7f800000) { // NaN (keep quiet)
+    return (x >> 16) | 0x40;
+  }
+  return (x + 0x7fff + ((x >> 16) & 1)) >> 16;
+}
+
+inline uint32_t bfloat_to_float_bits(uint16_t b) { return uint32_t(b) << 16; }
+
+// double -> float rounded to odd, so that the subsequent rounding to float16
+// (11 significand bits) or bfloat16 (8 bits) is correctly rounded. This holds
+// for targets with p + 2 <= 24 significand bits, float's precision.
+inline uint32_t double_to_float_bits_odd(double d) {
+  float const f = static_cast<float>(d);
+  uint32_t bits = float_to_bits(f);
+  double const back = f;
+
+  if (back != d && !std::isnan(d)) {
+    if (std::fabs(back) > std::fabs(d)) {
+      --bits;
+    }
+    bits |= 1;
+  }
+
+  return bits;
+}
+} // namespace detail
+
+//! IEEE 754 half-precision value as stored in '<f2' arrays
+struct float16 {
+  float16() = default;
+
+  template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+  explicit float16(T value)
+      : bits{std::is_same_v<T, double> || std::is_same_v<T, long double>
+                 ? detail::float_bits_to_half(detail::double_to_float_bits_odd(
+                       static_cast<double>(value)))
+                 : detail::float_bits_to_half(
+                       detail::float_to_bits(static_cast<float>(value)))} {}
+
+  operator float() const {
+    return detail::bits_to_float(detail::half_to_float_bits(bits));
+  }
+
+  static float16 from_bits(uint16_t b) {
+    float16 h;
+    h.bits = b;
+    return h;
+  }
+
+  uint16_t bits;
+};
+
+static_assert(sizeof(float16) == 2 && std::is_trivially_copyable_v<float16>);
+
+//! bfloat16 value (upper half of an IEEE 754 binary32). NumPy has no native
+//! type for it; arrays are stored with the raw 2-byte descriptor '<V2'.
+struct bfloat16 {
+  bfloat16() = default;
+
+  template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+  explicit bfloat16(T value)
+      : bits{std::is_same_v<T, double> || std::is_same_v<T, long double>
+                 ? detail::float_bits_to_bfloat(
+                       detail::double_to_float_bits_odd(
+                           static_cast<double>(value)))
+                 : detail::float_bits_to_bfloat(
+                       detail::float_to_bits(static_cast<float>(value)))} {}
+
+  operator float() const {
+    return detail::bits_to_float(detail::bfloat_to_float_bits(bits));
+  }
+
+  static bfloat16 from_bits(uint16_t b) {
+    bfloat16 h;
+    h.bits = b;
+    return h;
+  }
+
+  uint16_t bits;
+};
+
+static_assert(sizeof(bfloat16) == 2 &&
+              std::is_trivially_copyable_v<bfloat16>);
+
+} // namespace cnpypp
@@ -8,10 +8,18 @@
 #include <complex>
 #include <type_traits>
 
+#include <cnpy++/half.hpp>
+
 namespace cnpypp {
 
 template <typename F> char constexpr map_type(std::complex<F>) { return 'c'; }
 
+char constexpr map_type(float16) { return 'f'; }
+
+// bfloat16 is stored as 'V2', which any 2-byte void type (including padding)
+// shares, so it is not recognized when loading without being asked for
+char constexpr map_type(bfloat16) { return 'V'; }
+
 template <typename T> char constexpr map_type(T) {
   static_assert(std::is_arithmetic_v<T>, "only arithmetic types supported");
 
@@ -0,0 +1,100 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+#if __has_include(<version>)
+#include <version>
+#endif
+
+#if defined(__cpp_lib_mdspan) && __cpp_lib_mdspan >= 202207L
+#include <mdspan>
+#endif
+
+namespace cnpypp {
+#if defined(__cpp_lib_mdspan) && __cpp_lib_mdspan >= 202207L
+using std::layout_left;
+using std::layout_right;
+
+template <typename T, size_t Rank, typename Layout = layout_right>
+using mdspan = std::mdspan<T, std::dextents<size_t, Rank>, Layout>;
+#else
+// layout tags as in std::mdspan
+struct layout_right {}; // C order: last index varies fastest
+struct layout_left {};  // Fortran order: first index varies fastest
+
+// Minimal replacement for std::mdspan<T, std::dextents<size_t, Rank>,
+// Layout> where the standard library does not provide it yet. Only the
+// commonly used part of the interface is implemented.
+template <typename T, size_t Rank, typename Layout = layout_right>
+class mdspan {
+  static_assert(std::is_same_v<Layout, layout_right> ||
+                std::is_same_v<Layout, layout_left>);
+
+public:
+  using element_type = T;
+  using value_type = std::remove_cv_t<T>;
+  using index_type = size_t;
+  using layout_type = Layout;
+  using data_handle_type = T*;
+  using reference = T&;
+
+  constexpr mdspan() = default;
+
+  constexpr mdspan(T* data, std::array<index_type, Rank> const& extents)
+      : data_{data}, extents_{extents} {
+    index_type stride = 1;
+    for (size_t i = 0; i < Rank; ++i) {
+      size_t const r = std::is_same_v<Layout, layout_right> ? Rank - 1 - i : i;
+      strides_[r] = stride;
+      stride *= extents_[r];
+    }
+  }
+
+  static constexpr size_t rank() { return Rank; }
+
+  constexpr index_type extent(size_t r) const { return extents_[r]; }
+  constexpr index_type stride(size_t r) const { return strides_[r]; }
+
+  constexpr size_t size() const {
+    size_t n = 1;
+    for (size_t r = 0; r < Rank; ++r) {
+      n *= extents_[r];
+    }
+    return n;
+  }
+
+  constexpr bool empty() const { return size() == 0; }
+
+  constexpr T* data_handle() const { return data_; }
+
+  template <typename... TIndices>
+  constexpr reference operator()(TIndices... indices) const {
+    static_assert(sizeof...(TIndices) == Rank,
+                  "number of indices does not match rank");
+    return (*this)[std::array<index_type, Rank>{
+        static_cast<index_type>(indices)...}];
+  }
+
+  constexpr reference
+  operator[](std::array<index_type, Rank> const& indices) const {
+    index_type offset = 0;
+    for (size_t r = 0; r < Rank; ++r) {
+      offset += indices[r] * strides_[r];
+    }
+    return data_[offset];
+  }
+
+private:
+  T* data_ = nullptr;
+  std::array<index_type, Rank> extents_{};
+  std::array<index_type, Rank> strides_{};
+};
+#endif
+} // namespace cnpypp
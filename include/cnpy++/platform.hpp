@@ -0,0 +1,16 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#pragma once
+
+// CNPYPP_POSIX is defined where the POSIX I/O, mmap() and shm_open() APIs are
+// available. Features relying on file descriptors (FileDescriptorSink,
+// npy_load_fd(), NpyRowWriter, NpyAppender, NpyGrowableArray and the
+// shared-memory functions) are only provided then; elsewhere the remaining
+// functions fall back to portable implementations. Define CNPYPP_NO_POSIX to
+// force the portable code paths.
+#if !defined(CNPYPP_NO_POSIX) && (defined(__unix__) || defined(__APPLE__))
+#define CNPYPP_POSIX
+#endif
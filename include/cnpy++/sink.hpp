@@ -0,0 +1,81 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <cnpy++/platform.hpp>
+
+namespace cnpypp {
+// destination of serialized NPY data other than a std::ostream
+class Sink {
+protected:
+  Sink() = default;
+
+public:
+  virtual ~Sink() = default;
+
+  // announces the total number of bytes that are going to be written
+  virtual void reserve(size_t) {}
+
+  virtual void write(std::byte const* data, size_t size) = 0;
+
+  // writes header and payload in one go; the default issues two writes
+  virtual void write(std::byte const* header, size_t header_size,
+                     std::byte const* payload, size_t payload_size);
+};
+
+#ifdef CNPYPP_POSIX
+// writes to a POSIX file descriptor, header and payload with a single writev()
+class FileDescriptorSink : public Sink {
+public:
+  // does not take ownership of fd
+  FileDescriptorSink(int fd);
+
+  // creates or truncates the file fname
+  FileDescriptorSink(std::string const& fname);
+
+  FileDescriptorSink(FileDescriptorSink const&) = delete;
+  ~FileDescriptorSink();
+
+  virtual void write(std::byte const* data, size_t size) override;
+  virtual void write(std::byte const* header, size_t header_size,
+                     std::byte const* payload, size_t payload_size) override;
+
+private:
+  int const fd;
+  bool const owning;
+};
+#endif
+
+// appends to a std::vector<std::byte>
+class MemorySink : public Sink {
+public:
+  MemorySink(std::vector<std::byte>& target);
+
+  virtual void reserve(size_t size) override;
+  virtual void write(std::byte const* data, size_t size) override;
+
+private:
+  std::vector<std::byte>& target;
+};
+
+// passes the data to a user-supplied function
+class CallbackSink : public Sink {
+public:
+  using callback_type = std::function<void(std::byte const*, size_t)>;
+
+  CallbackSink(callback_type callback);
+
+  virtual void write(std::byte const* data, size_t size) override;
+
+private:
+  callback_type callback;
+};
+} // namespace cnpypp
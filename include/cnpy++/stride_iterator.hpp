@@ -39,6 +39,10 @@ public:
     return ptr_ == other.ptr_;
   }
 
+  std::ptrdiff_t operator-(stride_iterator const& other) const {
+    return (ptr_ - other.ptr_) / stride_;
+  }
+
 private:
   std::byte* ptr_;
   std::ptrdiff_t const stride_;
@@ -0,0 +1,206 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cnpy++/tuple_util.hpp>
+
+// Makes the aggregate struct Type usable as element type of structured
+// arrays. All non-static data members have to be listed in declaration
+// order; their names are used as field labels. Use at namespace scope in the
+// namespace of Type, e.g.
+//
+//   struct Particle { double x, y, z; int32_t id; };
+//   CNPYPP_STRUCT(Particle, x, y, z, id)
+#define CNPYPP_STRUCT(Type, ...)                                               \
+  [[maybe_unused]] inline auto cnpypp_struct_fields(Type& value) {             \
+    auto& [__VA_ARGS__] = value;                                               \
+    return std::tie(__VA_ARGS__);                                              \
+  }                                                                            \
+  [[maybe_unused]] inline auto cnpypp_struct_fields(Type const& value) {       \
+    auto const& [__VA_ARGS__] = value;                                         \
+    return std::tie(__VA_ARGS__);                                              \
+  }                                                                            \
+  [[maybe_unused]] constexpr char const* cnpypp_struct_names(Type const*) {    \
+    return #__VA_ARGS__;                                                       \
+  }
+
+namespace cnpypp {
+
+namespace detail {
+template <typename T> struct remove_tuple_refs {};
+
+template <typename... Types> struct remove_tuple_refs<std::tuple<Types...>> {
+  using type = std::tuple<std::remove_cv_t<std::remove_reference_t<Types>>...>;
+};
+
+// splits the stringized member list "a, b, c" of CNPYPP_STRUCT into names
+template <size_t N>
+std::array<std::string_view, N> constexpr split_names(std::string_view list) {
+  std::array<std::string_view, N> names{};
+  size_t pos = 0;
+
+  for (size_t i = 0; i < N; ++i) {
+    size_t end = list.find(',', pos);
+    if (end == std::string_view::npos) {
+      end = list.size();
+    }
+
+    std::string_view name = list.substr(pos, end - pos);
+    while (!name.empty() && name.front() == ' ') {
+      name.remove_prefix(1);
+    }
+    while (!name.empty() && name.back() == ' ') {
+      name.remove_suffix(1);
+    }
+
+    names[i] = name;
+    pos = std::min(end + 1, list.size());
+  }
+
+  return names;
+}
+
+template <typename T, typename = void>
+struct has_struct_info : std::false_type {};
+
+template <typename T>
+struct has_struct_info<
+    T, std::void_t<decltype(cnpypp_struct_fields(std::declval<T&>()))>>
+    : std::true_type {};
+} // namespace detail
+
+// true for structs registered with CNPYPP_STRUCT
+template <typename T>
+bool constexpr has_struct_info_v = detail::has_struct_info<T>::value;
+
+// field information of a struct registered with CNPYPP_STRUCT, with the same
+// members as tuple_info. Structs are stored with their in-memory layout, i.e.
+// offsets and itemsize include padding, so that file data can be accessed
+// directly as T.
+template <typename T> struct struct_info {
+  static_assert(has_struct_info_v<T>, "struct not registered (CNPYPP_STRUCT)");
+
+  using tuple_type = typename detail::remove_tuple_refs<decltype(
+      cnpypp_struct_fields(std::declval<T&>()))>::type;
+
+  static auto constexpr size = tuple_info<tuple_type>::size;
+  static bool constexpr has_bool_element =
+      tuple_info<tuple_type>::has_bool_element;
+  static auto constexpr data_types = tuple_info<tuple_type>::data_types;
+  static auto constexpr element_sizes = tuple_info<tuple_type>::element_sizes;
+  static auto constexpr sum_sizes = tuple_info<tuple_type>::sum_sizes;
+
+  static std::vector<std::vector<size_t>> field_shapes() {
+    return tuple_info<tuple_type>::field_shapes();
+  }
+
+  // no padding between or after the members
+  static bool constexpr is_packed = sum_sizes == sizeof(T);
+
+private:
+  template <size_t... I>
+  static std::array<size_t, size> constexpr get_alignments(
+      std::index_sequence<I...>) {
+    return {alignof(std::tuple_element_t<I, tuple_type>)...};
+  }
+
+  static auto constexpr alignments =
+      get_alignments(std::make_index_sequence<size>{});
+
+  static size_t constexpr align_up(size_t pos, size_t alignment) {
+    return (pos + alignment - 1) / alignment * alignment;
+  }
+
+  // members are placed at the next multiple of their alignment unless the
+  // struct is packed (e.g. #pragma pack(1))
+  static std::array<size_t, size> constexpr calc_offsets() {
+    std::array<size_t, size> result{};
+    size_t pos = 0;
+
+    for (size_t i = 0; i < size; ++i) {
+      result[i] = is_packed ? pos : align_up(pos, alignments[i]);
+      pos = result[i] + element_sizes[i];
+    }
+
+    return result;
+  }
+
+  static size_t constexpr calc_itemsize() {
+    size_t max_alignment = 1;
+    for (auto const a : alignments) {
+      max_alignment = std::max(max_alignment, a);
+    }
+
+    return is_packed ? sum_sizes
+                     : align_up(calc_offsets()[size - 1] +
+                                    element_sizes[size - 1],
+                                max_alignment);
+  }
+
+public:
+  static std::array<size_t, size> constexpr offsets = calc_offsets();
+  static size_t constexpr itemsize = calc_itemsize();
+
+  static_assert(itemsize == sizeof(T),
+                "unsupported struct layout (alignas or #pragma pack)");
+
+  static std::array<std::string_view, size> constexpr labels =
+      detail::split_names<size>(
+          cnpypp_struct_names(static_cast<T const*>(nullptr)));
+
+  struct_info() = delete;
+};
+
+namespace detail {
+// fields as listed in the header, including unnamed void fields for padding
+struct field_list {
+  std::vector<std::string_view> labels;
+  std::vector<char> data_types;
+  std::vector<size_t> word_sizes;
+  std::vector<std::vector<size_t>> field_shapes;
+
+  void add(std::string_view label, char data_type, size_t word_size,
+           std::vector<size_t> field_shape = {}) {
+    labels.push_back(label);
+    data_types.push_back(data_type);
+    word_sizes.push_back(word_size);
+    field_shapes.push_back(std::move(field_shape));
+  }
+};
+} // namespace detail
+
+template <typename T> detail::field_list struct_fields() {
+  using info = struct_info<T>;
+  detail::field_list fields;
+  auto field_shapes = info::field_shapes();
+  size_t pos = 0;
+
+  for (size_t i = 0; i < info::size; ++i) {
+    if (info::offsets[i] > pos) {
+      fields.add("", 'V', info::offsets[i] - pos);
+    }
+    fields.add(info::labels[i], info::data_types[i], info::element_sizes[i],
+               std::move(field_shapes[i]));
+    pos = info::offsets[i] + info::element_sizes[i];
+  }
+
+  if (info::itemsize > pos) {
+    fields.add("", 'V', info::itemsize - pos);
+  }
+
+  return fields;
+}
+
+} // namespace cnpypp
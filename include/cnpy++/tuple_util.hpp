@@ -11,6 +11,7 @@
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <boost/iterator/iterator_facade.hpp>
 
@@ -57,6 +58,27 @@ template <typename T> bool constexpr has_bool() {
   return has_bool_impl<T, std::tuple_size<T>::value, 0>();
 }
 
+// (nested) std::array fields are stored as sub-arrays, e.g.
+// std::array<double, 3> as ('name', '<f8', (3,))
+template <typename T> struct subarray {
+  using element_type = T;
+
+  static std::vector<size_t> shape() { return {}; }
+};
+
+template <typename T, size_t N> struct subarray<std::array<T, N>> {
+  using element_type = typename subarray<T>::element_type;
+
+  static std::vector<size_t> shape() {
+    auto result = subarray<T>::shape();
+    result.insert(result.begin(), N);
+    return result;
+  }
+};
+
+template <typename T>
+using subarray_element_t = typename subarray<T>::element_type;
+
 } // namespace detail
 
 template <typename Tup> struct tuple_info {
@@ -104,6 +126,11 @@ private:
 public:
   static size_t constexpr sum_sizes = sum_size_impl();
 
+  // sub-array shapes of the elements (empty for scalar elements)
+  static std::vector<std::vector<size_t>> field_shapes() {
+    return field_shapes_impl(std::make_index_sequence<size>{});
+  }
+
 private:
   static std::array<size_t, size> constexpr calc_offsets() {
     std::array<size_t, size> offsets{};
@@ -119,7 +146,8 @@ private:
   template <int k>
   static void constexpr getDataTypes_impl(std::array<char, size>& sizes) {
     if constexpr (k < size) {
-      sizes[k] = map_type(std::tuple_element_t<k, Tup>{});
+      sizes[k] = map_type(
+          detail::subarray_element_t<std::tuple_element_t<k, Tup>>{});
       getDataTypes_impl<k + 1>(sizes);
     }
   }
@@ -132,6 +160,12 @@ private:
     }
   }
 
+  template <size_t... I>
+  static std::vector<std::vector<size_t>>
+  field_shapes_impl(std::index_sequence<I...>) {
+    return {detail::subarray<std::tuple_element_t<I, Tup>>::shape()...};
+  }
+
   template <int k>
   static void constexpr calc_offsets_impl(std::array<size_t, size>& offsets) {
     if constexpr (k < size) {
@@ -194,14 +228,17 @@ public:
 private:
   friend class boost::iterator_core_access;
 
+  // signed, so that distances and steps backwards work
+  static std::ptrdiff_t constexpr stride = tuple_info<Tup>::sum_sizes;
+
   void increment() { ptr_ += tuple_info<Tup>::sum_sizes; }
 
   void decrement() { ptr_ -= tuple_info<Tup>::sum_sizes; }
 
-  void advance(size_t n) { ptr_ += n * tuple_info<Tup>::sum_sizes; }
+  void advance(std::ptrdiff_t n) { ptr_ += n * stride; }
 
   std::ptrdiff_t distance_to(tuple_iterator const& other) const {
-    return (other.ptr_ - ptr_) / tuple_info<Tup>::sum_sizes;
+    return (other.ptr_ - ptr_) / stride;
   }
 
   template <int k> void constexpr unpack(pointer_tuple_t& ptrTup) const {
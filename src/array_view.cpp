@@ -0,0 +1,165 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+using namespace cnpypp;
+
+NpyArrayView::NpyArrayView(std::shared_ptr<Buffer> buffer,
+                           std::ptrdiff_t offset, std::vector<size_t> shape,
+                           std::vector<std::ptrdiff_t> strides,
+                           std::vector<size_t> word_sizes,
+                           std::vector<std::string> labels)
+    : buffer_{std::move(buffer)}, offset_{offset}, shape_{std::move(shape)},
+      strides_{std::move(strides)}, word_sizes_{std::move(word_sizes)},
+      labels_{std::move(labels)},
+      total_value_size_{std::accumulate(word_sizes_.begin(), word_sizes_.end(),
+                                        size_t{0}, std::plus<size_t>())} {
+  if (shape_.size() != strides_.size()) {
+    throw std::invalid_argument(
+        "NpyArrayView: shape and strides differ in size");
+  }
+}
+
+NpyArrayView NpyArrayView::slice(size_t axis, size_t begin, size_t end,
+                                 size_t step) const {
+  if (axis >= rank()) {
+    throw std::out_of_range("NpyArrayView::slice: invalid axis");
+  } else if (step == 0) {
+    throw std::invalid_argument("NpyArrayView::slice: step must not be zero");
+  }
+
+  end = std::min(end, shape_[axis]);
+  begin = std::min(begin, end);
+
+  NpyArrayView result{*this};
+  result.offset_ += static_cast<std::ptrdiff_t>(begin) * strides_[axis];
+  result.shape_[axis] = (end - begin + step - 1) / step;
+  result.strides_[axis] *= static_cast<std::ptrdiff_t>(step);
+  return result;
+}
+
+NpyArrayView NpyArrayView::select(size_t axis, size_t index) const {
+  if (axis >= rank()) {
+    throw std::out_of_range("NpyArrayView::select: invalid axis");
+  } else if (index >= shape_[axis]) {
+    throw std::out_of_range("NpyArrayView::select: index out of range");
+  }
+
+  NpyArrayView result{*this};
+  result.offset_ += static_cast<std::ptrdiff_t>(index) * strides_[axis];
+  result.shape_.erase(result.shape_.begin() + axis);
+  result.strides_.erase(result.strides_.begin() + axis);
+  return result;
+}
+
+NpyArrayView NpyArrayView::transpose() const {
+  NpyArrayView result{*this};
+  std::reverse(result.shape_.begin(), result.shape_.end());
+  std::reverse(result.strides_.begin(), result.strides_.end());
+  return result;
+}
+
+NpyArrayView
+NpyArrayView::transpose(cnpypp::span<size_t const> axes) const {
+  std::vector<bool> seen(rank(), false);
+
+  if (axes.size() != rank()) {
+    throw std::invalid_argument(
+        "NpyArrayView::transpose: axes do not match rank");
+  }
+
+  NpyArrayView result{*this};
+
+  for (size_t i = 0; i < axes.size(); ++i) {
+    if (axes[i] >= rank() || seen[axes[i]]) {
+      throw std::invalid_argument(
+          "NpyArrayView::transpose: axes are not a permutation");
+    }
+    seen[axes[i]] = true;
+    result.shape_[i] = shape_[axes[i]];
+    result.strides_[i] = strides_[axes[i]];
+  }
+
+  return result;
+}
+
+bool NpyArrayView::is_contiguous(MemoryOrder order) const {
+  std::ptrdiff_t expected = total_value_size_;
+
+  for (size_t i = 0; i < rank(); ++i) {
+    size_t const axis = (order == MemoryOrder::C) ? rank() - 1 - i : i;
+
+    if (shape_[axis] != 1 && strides_[axis] != expected) {
+      return false;
+    }
+    expected *= shape_[axis];
+  }
+
+  return true;
+}
+
+std::ptrdiff_t
+NpyArrayView::byte_offset(cnpypp::span<size_t const> index) const {
+  if (index.size() != rank()) {
+    throw std::invalid_argument("NpyArrayView::at: index does not match rank");
+  }
+
+  std::ptrdiff_t offset = offset_;
+
+  for (size_t i = 0; i < rank(); ++i) {
+    if (index[i] >= shape_[i]) {
+      throw std::out_of_range("NpyArrayView::at: index out of range");
+    }
+    offset += static_cast<std::ptrdiff_t>(index[i]) * strides_[i];
+  }
+
+  return offset;
+}
+
+std::ptrdiff_t NpyArrayView::flat_stride() const {
+  // axes of extent 1 do not matter; the remaining ones have to be
+  // traversable with the stride of the last of them
+  std::ptrdiff_t stride = total_value_size_;
+  bool found = false;
+  size_t extent = 1;
+
+  for (size_t i = rank(); i-- > 0;) {
+    if (shape_[i] == 1) {
+      continue;
+    } else if (!found) {
+      stride = strides_[i];
+      found = true;
+    } else if (strides_[i] != stride * static_cast<std::ptrdiff_t>(extent)) {
+      throw std::runtime_error(
+          "NpyArrayView: elements cannot be traversed with a single stride");
+    }
+    extent *= shape_[i];
+  }
+
+  return stride;
+}
+
+NpyArrayView NpyArray::view() const {
+  std::vector<std::ptrdiff_t> strides(shape.size());
+  std::ptrdiff_t stride = total_value_size;
+
+  for (size_t i = 0; i < shape.size(); ++i) {
+    size_t const axis =
+        (memory_order == MemoryOrder::C) ? shape.size() - 1 - i : i;
+    strides[axis] = stride;
+    stride *= shape[axis];
+  }
+
+  return NpyArrayView{buffer, 0, shape, std::move(strides), word_sizes,
+                      labels};
+}
@@ -0,0 +1,231 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <cnpy++/bits.hpp>
+
+#if (defined(__GNUC__) || defined(__clang__)) &&                               \
+    (defined(__x86_64__) || defined(__i386__))
+#define CNPYPP_X86_SIMD
+#include <immintrin.h>
+#endif
+
+using namespace cnpypp;
+
+static void pack_scalar(bool const* src, size_t n, uint8_t* dst,
+                        BitOrder order) {
+  for (size_t i = 0; i < n; i += 8) {
+    uint8_t byte = 0;
+    for (size_t k = 0; k < 8 && i + k < n; ++k) {
+      unsigned const shift = (order == BitOrder::Big) ? 7 - k : k;
+      byte |= static_cast<uint8_t>(src[i + k] ? 1u << shift : 0);
+    }
+    dst[i / 8] = byte;
+  }
+}
+
+static void unpack_scalar(uint8_t const* src, size_t n, bool* dst,
+                          BitOrder order) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = detail::test_bit(src, i, order);
+  }
+}
+
+static unsigned popcount_scalar(uint64_t x) {
+  x = x - ((x >> 1) & 0x5555555555555555);
+  x = (x & 0x3333333333333333) + ((x >> 2) & 0x3333333333333333);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0f;
+  return (x * 0x0101010101010101) >> 56;
+}
+
+static size_t count_scalar(uint8_t const* bytes, size_t num_bytes) {
+  size_t count = 0;
+  size_t i = 0;
+  for (; i + 8 <= num_bytes; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    count += popcount_scalar(word);
+  }
+  for (; i < num_bytes; ++i) {
+    count += popcount_scalar(bytes[i]);
+  }
+  return count;
+}
+
+#ifdef CNPYPP_X86_SIMD
+// reverses the bytes within each group of 8, so that movemask yields the
+// first element in the most significant bit of each byte
+__attribute__((target("avx2"))) static __m256i
+reverse_groups_of_8(__m256i x) {
+  __m256i const reverse =
+      _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7,
+                       6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+  return _mm256_shuffle_epi8(x, reverse);
+}
+
+__attribute__((target("avx2"))) static void
+pack_avx2(bool const* src, size_t n, uint8_t* dst, BitOrder order) {
+  __m256i const zero = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i));
+    if (order == BitOrder::Big) {
+      x = reverse_groups_of_8(x);
+    }
+    uint32_t const mask = ~static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, zero)));
+    std::memcpy(dst + i / 8, &mask, sizeof(mask)); // little endian on x86
+  }
+  pack_scalar(src + i, n - i, dst + i / 8, order);
+}
+
+__attribute__((target("avx2"))) static void
+unpack_avx2(uint8_t const* src, size_t n, bool* dst, BitOrder order) {
+  // byte j of the result is taken from source byte j / 8
+  __m256i const spread =
+      _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2,
+                       2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+  __m256i const bit =
+      (order == BitOrder::Big)
+          ? _mm256_set1_epi64x(0x0102040810204080)
+          : _mm256_set1_epi64x(static_cast<int64_t>(0x8040201008040201));
+  __m256i const one = _mm256_set1_epi8(1);
+
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    int32_t word;
+    std::memcpy(&word, src + i / 8, sizeof(word));
+    __m256i const bytes = _mm256_shuffle_epi8(_mm256_set1_epi32(word), spread);
+    __m256i const set = _mm256_cmpeq_epi8(_mm256_and_si256(bytes, bit), bit);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm256_and_si256(set, one));
+  }
+  unpack_scalar(src + i / 8, n - i, dst + i, order);
+}
+
+// per-nibble lookup with vpshufb, summed up with vpsadbw
+__attribute__((target("avx2"))) static size_t
+count_avx2(uint8_t const* bytes, size_t num_bytes) {
+  __m256i const lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1,
+                       2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  __m256i const low_nibbles = _mm256_set1_epi8(0x0f);
+  __m256i sum = _mm256_setzero_si256();
+
+  size_t i = 0;
+  for (; i + 32 <= num_bytes; i += 32) {
+    __m256i const x =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(bytes + i));
+    __m256i const lo = _mm256_and_si256(x, low_nibbles);
+    __m256i const hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_nibbles);
+    __m256i const counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                           _mm256_shuffle_epi8(lookup, hi));
+    sum = _mm256_add_epi64(sum,
+                           _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+  }
+
+  alignas(32) uint64_t partial[4];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(partial), sum);
+  return partial[0] + partial[1] + partial[2] + partial[3] +
+         count_scalar(bytes + i, num_bytes - i);
+}
+
+__attribute__((target("popcnt"))) static size_t
+count_popcnt(uint8_t const* bytes, size_t num_bytes) {
+  size_t count = 0;
+  size_t i = 0;
+  for (; i + 8 <= num_bytes; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    count += __builtin_popcountll(word);
+  }
+  for (; i < num_bytes; ++i) {
+    count += __builtin_popcount(bytes[i]);
+  }
+  return count;
+}
+#endif
+
+static size_t count_bytes(uint8_t const* bytes, size_t num_bytes) {
+#ifdef CNPYPP_X86_SIMD
+  if (__builtin_cpu_supports("avx2")) {
+    return count_avx2(bytes, num_bytes);
+  } else if (__builtin_cpu_supports("popcnt")) {
+    return count_popcnt(bytes, num_bytes);
+  }
+#endif
+  return count_scalar(bytes, num_bytes);
+}
+
+void cnpypp::pack_bits(bool const* src, size_t n, uint8_t* dst,
+                       BitOrder order) {
+#ifdef CNPYPP_X86_SIMD
+  if (__builtin_cpu_supports("avx2")) {
+    return pack_avx2(src, n, dst, order);
+  }
+#endif
+  pack_scalar(src, n, dst, order);
+}
+
+void cnpypp::unpack_bits(uint8_t const* src, size_t n, bool* dst,
+                         BitOrder order) {
+#ifdef CNPYPP_X86_SIMD
+  if (__builtin_cpu_supports("avx2")) {
+    return unpack_avx2(src, n, dst, order);
+  }
+#endif
+  unpack_scalar(src, n, dst, order);
+}
+
+size_t cnpypp::count_bits(uint8_t const* bits, size_t n, BitOrder order) {
+  size_t const full = n / 8;
+  size_t count = count_bytes(bits, full);
+  if (n % 8 != 0) {
+    count += popcount_scalar(bits[full] & detail::tail_mask(n, order));
+  }
+  return count;
+}
+
+bool cnpypp::any_bits(uint8_t const* bits, size_t n, BitOrder order) {
+  size_t const full = n / 8;
+  uint64_t acc = 0;
+  size_t i = 0;
+  // no early exit per byte, so that the loop can be vectorized
+  for (; i + 256 <= full; i += 256) {
+    for (size_t k = 0; k < 256; ++k) {
+      acc |= bits[i + k];
+    }
+    if (acc != 0) {
+      return true;
+    }
+  }
+  for (; i < full; ++i) {
+    acc |= bits[i];
+  }
+  return acc != 0 ||
+         (n % 8 != 0 && (bits[full] & detail::tail_mask(n, order)) != 0);
+}
+
+bool cnpypp::all_bits(uint8_t const* bits, size_t n, BitOrder order) {
+  size_t const full = n / 8;
+  uint8_t acc = 0xff;
+  size_t i = 0;
+  for (; i + 256 <= full; i += 256) {
+    for (size_t k = 0; k < 256; ++k) {
+      acc &= bits[i + k];
+    }
+    if (acc != 0xff) {
+      return false;
+    }
+  }
+  for (; i < full; ++i) {
+    acc &= bits[i];
+  }
+  uint8_t const mask = detail::tail_mask(n, order);
+  return acc == 0xff && (n % 8 == 0 || (bits[full] & mask) == mask);
+}
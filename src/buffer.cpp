@@ -3,12 +3,22 @@
 // license available in LICENSE file, or at
 // http://www.opensource.org/licenses/mit-license.php
 
+#include <algorithm>
+#include <cerrno>
 #include <cstddef>
+#include <system_error>
+#include <utility>
 
 #include <boost/iostreams/device/mapped_file.hpp>
 
 #include <cnpy++/buffer.hpp>
 
+#ifdef CNPYPP_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 cnpypp::InMemoryBuffer::InMemoryBuffer(size_t size)
     : buffer{std::make_unique<std::byte[]>(size)} {}
 
@@ -19,15 +29,121 @@ std::byte* cnpypp::InMemoryBuffer::data() {
       static_cast<InMemoryBuffer const&>(*this).data());
 }
 
+cnpypp::ExternalBuffer::ExternalBuffer(std::byte* data,
+                                       std::function<void()> release_)
+    : buffer{data}, release{std::move(release_)} {}
+
+cnpypp::ExternalBuffer::~ExternalBuffer() {
+  if (release) {
+    release();
+  }
+}
+
+std::byte* cnpypp::ExternalBuffer::data() { return buffer; }
+
+std::byte const* cnpypp::ExternalBuffer::data() const { return buffer; }
+
 static auto const alignment = boost::iostreams::mapped_file::alignment();
 
+enum class Advice { sequential, random, hugepages, willneed, dontneed };
+
+#ifdef CNPYPP_POSIX
+static size_t const page_size = ::sysconf(_SC_PAGESIZE);
+
+// applies advice to [offset, offset + length) of the mapping starting at the
+// page-aligned address mapping, widened to whole pages
+static void advise(void* mapping, size_t mapping_length, size_t offset,
+                   size_t length, Advice advice) {
+  if (mapping == nullptr || offset >= mapping_length) {
+    return;
+  }
+
+  int flag;
+  switch (advice) {
+  case Advice::sequential:
+    flag = MADV_SEQUENTIAL;
+    break;
+  case Advice::random:
+    flag = MADV_RANDOM;
+    break;
+  case Advice::hugepages:
+#ifdef MADV_HUGEPAGE
+    flag = MADV_HUGEPAGE;
+    break;
+#else
+    return;
+#endif
+  case Advice::willneed:
+    flag = MADV_WILLNEED;
+    break;
+  default:
+    flag = MADV_DONTNEED;
+  }
+
+  length = std::min(length, mapping_length - offset);
+  size_t const begin = offset / page_size * page_size;
+
+  // advice is only a hint, so errors are ignored
+  ::madvise(static_cast<char*>(mapping) + begin, offset + length - begin,
+            flag);
+}
+#else
+// only used to fault in pages; touching more often than necessary is harmless
+static size_t constexpr page_size = 0x1000;
+
+// there is no portable equivalent of madvise()
+static void advise(void*, size_t, size_t, size_t, Advice) {}
+#endif
+
+static void apply_hints(void* mapping, size_t length, cnpypp::MapHint hints) {
+  using cnpypp::MapHint;
+
+  if (has_hint(hints, MapHint::sequential)) {
+    advise(mapping, length, 0, length, Advice::sequential);
+  }
+  if (has_hint(hints, MapHint::random)) {
+    advise(mapping, length, 0, length, Advice::random);
+  }
+  if (has_hint(hints, MapHint::hugepages)) {
+    advise(mapping, length, 0, length, Advice::hugepages);
+  }
+  if (has_hint(hints, MapHint::willneed)) {
+    advise(mapping, length, 0, length, Advice::willneed);
+  }
+  if (has_hint(hints, MapHint::populate)) {
+#ifdef MADV_POPULATE_READ
+    if (length > 0 && ::madvise(mapping, length, MADV_POPULATE_READ) == 0) {
+      return;
+    }
+#endif
+    // fallback for older kernels: fault in every page
+    volatile char const* const p = static_cast<char const*>(mapping);
+    for (size_t i = 0; i < length; i += page_size) {
+      (void)p[i];
+    }
+  }
+}
+
 cnpypp::MemoryMappedBuffer::MemoryMappedBuffer(std::string const& path,
-                                               size_t offset_, size_t length)
+                                               size_t offset_, size_t length,
+                                               MapHint hints)
     : offset{offset_ % alignment},
       buffer{path, boost::iostreams::mapped_file::mapmode::priv,
              offset + length,
              static_cast<boost::iostreams::stream_offset>(
-                 (offset_ / alignment) * alignment)} {}
+                 (offset_ / alignment) * alignment)} {
+  apply_hints(buffer.data(), buffer.size(), hints);
+}
+
+void cnpypp::MemoryMappedBuffer::prefetch(size_t offset_, size_t length) {
+  advise(buffer.data(), buffer.size(), offset + offset_, length,
+         Advice::willneed);
+}
+
+void cnpypp::MemoryMappedBuffer::evict(size_t offset_, size_t length) {
+  advise(buffer.data(), buffer.size(), offset + offset_, length,
+         Advice::dontneed);
+}
 
 std::byte const* cnpypp::MemoryMappedBuffer::data() const {
   return reinterpret_cast<std::byte const*>(buffer.data() + offset);
@@ -36,3 +152,117 @@ std::byte const* cnpypp::MemoryMappedBuffer::data() const {
 std::byte* cnpypp::MemoryMappedBuffer::data() {
   return reinterpret_cast<std::byte*>(buffer.data() + offset);
 }
+
+#ifdef CNPYPP_POSIX
+cnpypp::WritableMemoryMappedBuffer::WritableMemoryMappedBuffer(
+    std::string const& path, size_t offset_, size_t length_)
+    : offset{offset_ % page_size}, length{offset + length_},
+      mapping{nullptr} {
+  if (length == 0) {
+    return;
+  }
+
+  int const fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+
+  if (fd < 0) {
+    throw std::system_error{errno, std::generic_category(),
+                            "WritableMemoryMappedBuffer: could not open " +
+                                path};
+  }
+
+  try {
+    map(fd, offset_ - offset);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+
+  ::close(fd); // the mapping keeps the file referenced
+}
+
+cnpypp::WritableMemoryMappedBuffer::WritableMemoryMappedBuffer(int fd,
+                                                               size_t offset_,
+                                                               size_t length_)
+    : offset{offset_ % page_size}, length{offset + length_},
+      mapping{nullptr} {
+  if (length > 0) {
+    map(fd, offset_ - offset);
+  }
+}
+
+void cnpypp::WritableMemoryMappedBuffer::map(int fd, size_t aligned_offset) {
+  void* const addr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, static_cast<off_t>(aligned_offset));
+
+  if (addr == MAP_FAILED) {
+    throw std::system_error{errno, std::generic_category(),
+                            "WritableMemoryMappedBuffer: mmap() failed"};
+  }
+
+  mapping = addr;
+}
+
+cnpypp::WritableMemoryMappedBuffer::~WritableMemoryMappedBuffer() {
+  if (mapping != nullptr) {
+    ::munmap(mapping, length);
+  }
+}
+
+std::byte* cnpypp::WritableMemoryMappedBuffer::data() {
+  return static_cast<std::byte*>(mapping) + offset;
+}
+
+std::byte const* cnpypp::WritableMemoryMappedBuffer::data() const {
+  return static_cast<std::byte const*>(mapping) + offset;
+}
+
+void cnpypp::WritableMemoryMappedBuffer::sync() {
+  if (mapping != nullptr && ::msync(mapping, length, MS_SYNC) != 0) {
+    throw std::system_error{errno, std::generic_category(),
+                            "WritableMemoryMappedBuffer: msync() failed"};
+  }
+}
+
+void cnpypp::WritableMemoryMappedBuffer::prefetch(size_t offset_,
+                                                  size_t length_) {
+  advise(mapping, length, offset + offset_, length_, Advice::willneed);
+}
+
+// the mapping is shared, so the data remain in the page cache and the file
+void cnpypp::WritableMemoryMappedBuffer::evict(size_t offset_,
+                                               size_t length_) {
+  advise(mapping, length, offset + offset_, length_, Advice::dontneed);
+}
+#else
+cnpypp::WritableMemoryMappedBuffer::WritableMemoryMappedBuffer(
+    std::string const& path, size_t offset_, size_t length)
+    : offset{offset_ % alignment} {
+  if (length > 0) {
+    buffer.open(path, boost::iostreams::mapped_file::mapmode::readwrite,
+                offset + length,
+                static_cast<boost::iostreams::stream_offset>(offset_ -
+                                                             offset));
+  }
+}
+
+cnpypp::WritableMemoryMappedBuffer::~WritableMemoryMappedBuffer() = default;
+
+std::byte* cnpypp::WritableMemoryMappedBuffer::data() {
+  return buffer.is_open() ? reinterpret_cast<std::byte*>(buffer.data()) + offset
+                          : nullptr;
+}
+
+std::byte const* cnpypp::WritableMemoryMappedBuffer::data() const {
+  return buffer.is_open()
+             ? reinterpret_cast<std::byte const*>(buffer.const_data()) + offset
+             : nullptr;
+}
+
+// boost::iostreams::mapped_file cannot flush; the data are written back to
+// the file when the mapping is closed
+void cnpypp::WritableMemoryMappedBuffer::sync() {}
+
+void cnpypp::WritableMemoryMappedBuffer::prefetch(size_t, size_t) {}
+
+void cnpypp::WritableMemoryMappedBuffer::evict(size_t, size_t) {}
+#endif
@@ -4,15 +4,19 @@
 // http://www.opensource.org/licenses/mit-license.php
 
 #include <algorithm>
+#include <cerrno>
 #include <complex>
 #include <cstdlib>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <numeric>
 #include <regex>
 #include <stdexcept>
 #include <stdint.h>
+#include <system_error>
 
 #include <boost/endian/conversion.hpp>
 #include <boost/filesystem.hpp>
@@ -24,6 +28,10 @@
 
 #include "cnpy++.hpp"
 
+#ifdef CNPYPP_POSIX
+#include <unistd.h>
+#endif
+
 using namespace cnpypp;
 
 char cnpypp::BigEndianTest() {
@@ -44,13 +52,171 @@ bool cnpypp::_exists(std::string const& fname) {
 }
 
 static std::regex const num_regex("[0-9][0-9]*");
+// descriptors may be followed by a sub-array shape, e.g. ('pos', '<f8', (3,))
+static std::regex const dtype_tuple_regex(
+    "\\('(\\w*)', '([<>|])([a-zA-z])(\\d+)'(?:, \\(([\\d, ]*)\\))?\\)");
 static std::regex const
-    dtype_tuple_regex("\\('(\\w+)', '([<>|])([a-zA-z])(\\d+)'\\)");
+    dtype_regex("\\(?'([<>|])([a-zA-z])(\\d+)'(?:, \\(([\\d, ]*)\\))?\\)?");
+static std::regex const label_regex("'(\\w*)'");
+
+// size in bytes of an element given the type character and the number in
+// its descriptor, which counts UCS-4 characters for unicode strings ('U')
+static size_t word_size(char data_type, std::string const& number) {
+  size_t const n = std::stoul(number);
+  return (data_type == 'U') ? n * sizeof(char32_t) : n;
+}
+
+// appends a descriptor like <f8 or |S16 (without quotes)
+static void append_descr(std::vector<char>& dict, char data_type,
+                         size_t size) {
+  dict.push_back((data_type == 'S') ? '|' : BigEndianTest());
+  dict.push_back(data_type);
+  append(dict, std::to_string((data_type == 'U') ? size / sizeof(char32_t)
+                                                  : size));
+}
+
+// returns the part between the brackets of "'key': [...]" in dict
+static std::string_view list_entry(std::string_view dict,
+                                   std::string_view key) {
+  std::string const pattern = "'" + std::string{key} + "': [";
+
+  if (auto const begin = dict.find(pattern); begin == std::string_view::npos) {
+    return {};
+  } else if (auto const end = dict.find(']', begin);
+             end == std::string_view::npos) {
+    throw std::runtime_error("invalid header: malformed list in 'descr'");
+  } else {
+    return dict.substr(begin + pattern.size(),
+                       end - begin - pattern.size());
+  }
+}
+
+// sub-array shape in the optional shape group of a descriptor match
+static std::vector<size_t> field_shape(std::csub_match const& match) {
+  std::vector<size_t> result;
+
+  if (match.matched) {
+    for (auto it = std::cregex_iterator(match.first, match.second, num_regex);
+         it != std::cregex_iterator(); ++it) {
+      result.push_back(std::stoul(it->str()));
+    }
+  }
+
+  return result;
+}
+
+static size_t num_elements(std::vector<size_t> const& field_shape) {
+  return std::accumulate(field_shape.begin(), field_shape.end(), size_t{1},
+                         std::multiplies<size_t>());
+}
+
+// converts the dict form of a structured descr ({'names': [...], 'formats':
+// [...], 'offsets': [...], 'itemsize': n}) into fields in the order of their
+// offsets, with unnamed void fields for padding as in the list form
+static void parse_descr_dict(std::string_view descr,
+                             std::vector<size_t>& word_sizes,
+                             std::vector<char>& data_types,
+                             std::vector<std::string>& labels,
+                             std::vector<std::vector<size_t>>& field_shapes) {
+  struct Field {
+    std::string label;
+    char data_type;
+    size_t word_size;
+    size_t offset;
+    std::vector<size_t> shape;
+  };
+  std::vector<Field> fields;
+
+  std::string_view const names = list_entry(descr, "names");
+  std::string_view const formats = list_entry(descr, "formats");
+  std::string_view const offsets = list_entry(descr, "offsets");
+
+  for (auto it = std::cregex_iterator(names.begin(), names.end(), label_regex);
+       it != std::cregex_iterator(); ++it) {
+    fields.push_back(Field{(*it)[1].str(), 0, 0, 0, {}});
+  }
+
+  size_t i = 0;
+  for (auto it =
+           std::cregex_iterator(formats.begin(), formats.end(), dtype_regex);
+       it != std::cregex_iterator(); ++it, ++i) {
+    if (i >= fields.size()) {
+      throw std::runtime_error(
+          "invalid header: 'formats' do not match 'names'");
+    } else if ((*it)[1].str() == ">") {
+      throw std::runtime_error("parse_npy_header: data stored in big-endian "
+                               "format (not supported)");
+    }
+    fields[i].data_type = *((*it)[2].first);
+    fields[i].shape = field_shape((*it)[4]);
+    fields[i].word_size = word_size(fields[i].data_type, (*it)[3].str()) *
+                          num_elements(fields[i].shape);
+  }
+
+  if (i != fields.size() || fields.empty()) {
+    throw std::runtime_error("invalid header: 'formats' do not match 'names'");
+  }
+
+  if (offsets.empty()) { // packed
+    for (size_t k = 1; k < fields.size(); ++k) {
+      fields[k].offset = fields[k - 1].offset + fields[k - 1].word_size;
+    }
+  } else {
+    i = 0;
+    for (auto it =
+             std::cregex_iterator(offsets.begin(), offsets.end(), num_regex);
+         it != std::cregex_iterator(); ++it, ++i) {
+      if (i >= fields.size()) {
+        throw std::runtime_error(
+            "invalid header: 'offsets' do not match 'names'");
+      }
+      fields[i].offset = std::stoul(it->str());
+    }
+
+    if (i != fields.size()) {
+      throw std::runtime_error(
+          "invalid header: 'offsets' do not match 'names'");
+    }
+  }
+
+  std::stable_sort(
+      fields.begin(), fields.end(),
+      [](Field const& a, Field const& b) { return a.offset < b.offset; });
+
+  size_t position = 0;
+  auto add_padding = [&](size_t offset) {
+    if (offset < position) {
+      throw std::runtime_error(
+          "parse_npy_header: overlapping fields not supported");
+    } else if (offset > position) {
+      labels.emplace_back();
+      data_types.push_back('V');
+      word_sizes.push_back(offset - position);
+      field_shapes.emplace_back();
+    }
+  };
+
+  for (auto& field : fields) {
+    add_padding(field.offset);
+    labels.push_back(std::move(field.label));
+    data_types.push_back(field.data_type);
+    word_sizes.push_back(field.word_size);
+    field_shapes.push_back(std::move(field.shape));
+    position = field.offset + field.word_size;
+  }
+
+  std::cmatch matches;
+  if (std::regex_search(descr.begin(), descr.end(), matches,
+                        std::regex{"'itemsize': (\\d+)"})) {
+    add_padding(std::stoul(matches[1].str()));
+  }
+}
 
 void cnpypp::parse_npy_header(std::istream::char_type const* buffer,
                               std::vector<size_t>& word_sizes,
                               std::vector<char>& data_types,
                               std::vector<std::string>& labels,
+                              std::vector<std::vector<size_t>>& field_shapes,
                               std::vector<size_t>& shape,
                               cnpypp::MemoryOrder& memory_order) {
   uint8_t const major_version = *reinterpret_cast<uint8_t const*>(buffer + 6);
@@ -66,20 +232,60 @@ void cnpypp::parse_npy_header(std::istream::char_type const* buffer,
     throw std::runtime_error("parse_npy_header: version not supported");
   }
 
-  parse_npy_dict(header, word_sizes, data_types, labels, shape, memory_order);
+  parse_npy_dict(header, word_sizes, data_types, labels, field_shapes, shape,
+                 memory_order);
 }
 
 static std::string_view const npy_magic_string = "\x93NUMPY";
 
+size_t cnpypp::parse_npy_header(
+    cnpypp::span<std::istream::char_type const> buffer,
+    std::vector<size_t>& word_sizes, std::vector<char>& data_types,
+    std::vector<std::string>& labels,
+    std::vector<std::vector<size_t>>& field_shapes, std::vector<size_t>& shape,
+    cnpypp::MemoryOrder& memory_order) {
+  if (buffer.size() < 10) {
+    throw std::runtime_error("parse_npy_header: buffer too small");
+  } else if (!std::equal(npy_magic_string.begin(), npy_magic_string.end(),
+                         buffer.begin())) {
+    throw std::runtime_error("parse_npy_header: NPY magic string not found");
+  }
+
+  uint8_t const major_version = buffer[6];
+  uint8_t const minor_version = buffer[7];
+
+  if (major_version != 1 || minor_version != 0) {
+    throw std::runtime_error(
+        "parse_npy_header: NPY format version not supported");
+  }
+
+  uint16_t const header_len =
+      boost::endian::endian_load<boost::uint16_t, 2,
+                                 boost::endian::order::little>(
+          reinterpret_cast<unsigned char const*>(buffer.data() + 8));
+
+  if (header_len == 0 || buffer.size() - 10 < header_len) {
+    throw std::runtime_error("parse_npy_header: header exceeds buffer");
+  }
+
+  parse_npy_dict(buffer.subspan(10, header_len), word_sizes, data_types,
+                 labels, field_shapes, shape, memory_order);
+
+  return 10 + header_len;
+}
+
 void cnpypp::parse_npy_header(std::istream& fs, std::vector<size_t>& word_sizes,
                               std::vector<char>& data_types,
                               std::vector<std::string>& labels,
+                              std::vector<std::vector<size_t>>& field_shapes,
                               std::vector<size_t>& shape,
                               cnpypp::MemoryOrder& memory_order) {
   std::array<std::istream::char_type, 10> buffer;
   fs.read(buffer.data(), 10);
 
-  if (!std::equal(npy_magic_string.begin(), npy_magic_string.end(),
+  if (!fs) {
+    throw std::runtime_error("parse_npy_header: unexpected end of stream");
+  } else if (!std::equal(npy_magic_string.begin(), npy_magic_string.end(),
                   buffer.cbegin())) {
     throw std::runtime_error("parse_npy_header: NPY magic string not found");
   }
@@ -101,15 +307,20 @@ void cnpypp::parse_npy_header(std::istream& fs, std::vector<size_t>& word_sizes,
       std::make_unique<std::istream::char_type[]>(header_len);
   fs.read(header_buffer.get(), header_len);
 
+  if (!fs || header_len == 0) {
+    throw std::runtime_error("parse_npy_header: unexpected end of stream");
+  }
+
   parse_npy_dict(
       cnpypp::span<std::istream::char_type>(header_buffer.get(), header_len),
-      word_sizes, data_types, labels, shape, memory_order);
+      word_sizes, data_types, labels, field_shapes, shape, memory_order);
 }
 
 void cnpypp::parse_npy_dict(cnpypp::span<std::istream::char_type const> buffer,
                             std::vector<size_t>& word_sizes,
                             std::vector<char>& data_types,
                             std::vector<std::string>& labels,
+                            std::vector<std::vector<size_t>>& field_shapes,
                             std::vector<size_t>& shape,
                             cnpypp::MemoryOrder& memory_order) {
   if (buffer.back() != '\n') {
@@ -132,6 +343,7 @@ void cnpypp::parse_npy_dict(cnpypp::span<std::istream::char_type const> buffer,
   word_sizes.clear();
   data_types.clear();
   labels.clear();
+  field_shapes.clear();
   shape.clear();
 
   // read & fill shape
@@ -176,7 +388,7 @@ void cnpypp::parse_npy_dict(cnpypp::span<std::istream::char_type const> buffer,
                                  "format (not supported)");
       } else {
         data_types.push_back(*(matches[2].first));
-        word_sizes.push_back(std::stoi(matches[3].str()));
+        word_sizes.push_back(word_size(data_types.back(), matches[3].str()));
       }
     } else if (c == '[') {
       // structured type / tuple
@@ -201,15 +413,91 @@ void cnpypp::parse_npy_dict(cnpypp::span<std::istream::char_type const> buffer,
           }
 
           data_types.push_back(*(match[3].first));
-          word_sizes.push_back(std::stoi(match[4].str()));
+          field_shapes.push_back(field_shape(match[5]));
+          word_sizes.push_back(word_size(data_types.back(), match[4].str()) *
+                               num_elements(field_shapes.back()));
         }
       }
+    } else if (c == '{') {
+      // structured type in dict form (e.g. aligned)
+
+      if (auto const pos_end_dict =
+              dict.find('}', pos_start_desc + desc.size());
+          pos_end_dict == std::string_view::npos) {
+        throw std::runtime_error("invalid header: malformed dict in 'descr'");
+      } else {
+        parse_descr_dict(dict.substr(pos_start_desc + desc.size(),
+                                     pos_end_dict - pos_start_desc -
+                                         desc.size() + 1),
+                         word_sizes, data_types, labels, field_shapes);
+      }
     } else {
       throw std::runtime_error("invalid header: malformed 'descr'");
     }
   }
 }
 
+// the overloads without field_shapes cannot describe sub-array fields, so
+// arrays containing any are rejected instead of being misinterpreted
+static void
+reject_subarray_fields(std::vector<std::vector<size_t>> const& field_shapes,
+                       char const* function) {
+  for (auto const& field_shape : field_shapes) {
+    if (!field_shape.empty()) {
+      throw std::runtime_error(std::string{function} +
+                               ": sub-array fields require field_shapes");
+    }
+  }
+}
+
+void cnpypp::parse_npy_header(std::istream& fs, std::vector<size_t>& word_sizes,
+                              std::vector<char>& data_types,
+                              std::vector<std::string>& labels,
+                              std::vector<size_t>& shape,
+                              cnpypp::MemoryOrder& memory_order) {
+  std::vector<std::vector<size_t>> field_shapes;
+  parse_npy_header(fs, word_sizes, data_types, labels, field_shapes, shape,
+                   memory_order);
+  reject_subarray_fields(field_shapes, "parse_npy_header");
+}
+
+void cnpypp::parse_npy_header(std::istream::char_type const* buffer,
+                              std::vector<size_t>& word_sizes,
+                              std::vector<char>& data_types,
+                              std::vector<std::string>& labels,
+                              std::vector<size_t>& shape,
+                              cnpypp::MemoryOrder& memory_order) {
+  std::vector<std::vector<size_t>> field_shapes;
+  parse_npy_header(buffer, word_sizes, data_types, labels, field_shapes, shape,
+                   memory_order);
+  reject_subarray_fields(field_shapes, "parse_npy_header");
+}
+
+size_t cnpypp::parse_npy_header(
+    cnpypp::span<std::istream::char_type const> buffer,
+    std::vector<size_t>& word_sizes, std::vector<char>& data_types,
+    std::vector<std::string>& labels, std::vector<size_t>& shape,
+    cnpypp::MemoryOrder& memory_order) {
+  std::vector<std::vector<size_t>> field_shapes;
+  size_t const header_size =
+      parse_npy_header(buffer, word_sizes, data_types, labels, field_shapes,
+                       shape, memory_order);
+  reject_subarray_fields(field_shapes, "parse_npy_header");
+  return header_size;
+}
+
+void cnpypp::parse_npy_dict(cnpypp::span<std::istream::char_type const> buffer,
+                            std::vector<size_t>& word_sizes,
+                            std::vector<char>& data_types,
+                            std::vector<std::string>& labels,
+                            std::vector<size_t>& shape,
+                            cnpypp::MemoryOrder& memory_order) {
+  std::vector<std::vector<size_t>> field_shapes;
+  parse_npy_dict(buffer, word_sizes, data_types, labels, field_shapes, shape,
+                 memory_order);
+  reject_subarray_fields(field_shapes, "parse_npy_dict");
+}
+
 #ifndef NO_LIBZIP
 cnpypp::NpyArray load_npy(zip_t* archive, zip_int64_t index) {
   zip_stat_t fileinfo;
@@ -234,11 +522,12 @@ cnpypp::NpyArray load_npy(zip_t* archive, zip_int64_t index) {
   }
 
   std::vector<size_t> shape, word_sizes;
-  std::vector<char> data_types; // filled but not used
+  std::vector<char> data_types;
   std::vector<std::string> labels;
+  std::vector<std::vector<size_t>> field_shapes;
   MemoryOrder memory_order;
-  parse_npy_header(header_buffer.get(), word_sizes, data_types, labels, shape,
-                   memory_order);
+  parse_npy_header(header_buffer.get(), word_sizes, data_types, labels,
+                   field_shapes, shape, memory_order);
 
   auto const num_vals = std::accumulate(shape.begin(), shape.end(), size_t{1},
                                         std::multiplies<size_t>());
@@ -286,8 +575,9 @@ cnpypp::NpyArray load_npy(zip_t* archive, zip_int64_t index) {
   }
 
   zip_fclose(file);
-  return NpyArray{std::move(shape), std::move(word_sizes), std::move(labels),
-                  memory_order, std::move(buffer)};
+  return NpyArray{std::move(shape), std::move(word_sizes),
+                  std::move(data_types), std::move(labels),
+                  std::move(field_shapes), memory_order, std::move(buffer)};
 }
 #endif
 
@@ -359,6 +649,224 @@ cnpypp::NpyArray cnpypp::npz_load(std::string const& fname,
 
 cnpypp::NpyArray cnpypp::npy_load(std::string const& fname,
                                   bool memory_mapped) {
+  if (memory_mapped) {
+    return npy_load(fname, MapHint::none);
+  }
+
+  std::ifstream fs{fname, std::ios::binary};
+
+  if (!fs)
+    throw std::runtime_error("npy_load: Unable to open file " + fname);
+
+  return npy_load(fs);
+}
+
+
+cnpypp::NpyArray cnpypp::npy_load(std::string const& fname, MapHint hints) {
+  std::ifstream fs{fname, std::ios::binary};
+
+  if (!fs)
+    throw std::runtime_error("npy_load: Unable to open file " + fname);
+
+  std::vector<size_t> word_sizes, shape;
+  std::vector<char> data_types;
+  std::vector<std::string> labels;
+  std::vector<std::vector<size_t>> field_shapes;
+  cnpypp::MemoryOrder memory_order;
+
+  cnpypp::parse_npy_header(fs, word_sizes, data_types, labels, field_shapes,
+                           shape, memory_order);
+
+  auto const num_vals = std::accumulate(shape.begin(), shape.end(), size_t{1},
+                                        std::multiplies<size_t>());
+  auto const total_value_size = std::accumulate(
+      word_sizes.begin(), word_sizes.end(), size_t{0}, std::plus<size_t>());
+  auto const num_bytes = total_value_size * num_vals;
+
+  auto buffer = std::make_unique<MemoryMappedBuffer>(fname, fs.tellg(),
+                                                     num_bytes, hints);
+
+  return cnpypp::NpyArray{std::move(shape), std::move(word_sizes),
+                          std::move(data_types), std::move(labels),
+                          std::move(field_shapes), memory_order,
+                          std::move(buffer)};
+}
+
+cnpypp::NpyArray cnpypp::npy_create_mapped(std::string const& fname,
+                                           cnpypp::span<size_t const> shape,
+                                           char data_type, size_t word_size,
+                                           MemoryOrder memory_order) {
+  std::vector<char> const header =
+      create_npy_header(shape, data_type, word_size, memory_order);
+  size_t const num_bytes = std::accumulate(
+      shape.begin(), shape.end(), word_size, std::multiplies<size_t>());
+
+  {
+    std::ofstream fs{fname, std::ios::binary | std::ios::trunc};
+    fs.write(header.data(), header.size());
+
+    if (!fs) {
+      throw std::runtime_error("npy_create_mapped: Unable to write file " +
+                               fname);
+    }
+  }
+
+  boost::filesystem::resize_file(fname, header.size() + num_bytes);
+
+  return cnpypp::NpyArray{
+      std::vector<size_t>(shape.begin(), shape.end()),
+      {word_size},
+      {data_type},
+      {},
+      {},
+      memory_order,
+      std::make_unique<WritableMemoryMappedBuffer>(fname, header.size(),
+                                                   num_bytes)};
+}
+
+cnpypp::NpyArray cnpypp::npy_load(std::istream& fs) {
+  std::vector<size_t> word_sizes, shape;
+  std::vector<char> data_types;
+  std::vector<std::string> labels;
+  std::vector<std::vector<size_t>> field_shapes;
+  cnpypp::MemoryOrder memory_order;
+
+  cnpypp::parse_npy_header(fs, word_sizes, data_types, labels, field_shapes,
+                           shape, memory_order);
+
+  auto const num_vals = std::accumulate(shape.begin(), shape.end(), size_t{1},
+                                        std::multiplies<size_t>());
+  auto const total_value_size = std::accumulate(
+      word_sizes.begin(), word_sizes.end(), size_t{0}, std::plus<size_t>());
+  auto const num_bytes = total_value_size * num_vals;
+
+  auto buffer = std::make_unique<InMemoryBuffer>(num_bytes);
+  fs.read(reinterpret_cast<char*>(buffer->data()), num_bytes);
+
+  if (static_cast<size_t>(fs.gcount()) != num_bytes) {
+    throw std::runtime_error("npy_load: unexpected end of stream");
+  }
+
+  return cnpypp::NpyArray{std::move(shape), std::move(word_sizes),
+                          std::move(data_types), std::move(labels),
+                          std::move(field_shapes), memory_order,
+                          std::move(buffer)};
+}
+
+#ifdef CNPYPP_POSIX
+// reads until size bytes are read or EOF is reached, returns bytes read
+static size_t read_fully(int fd, std::byte* dst, size_t size) {
+  size_t total = 0;
+
+  while (total < size) {
+    // single read() calls are limited to a bit less than 2 GiB on Linux
+    size_t const count = std::min(size - total, size_t{1} << 30);
+    ssize_t const n = ::read(fd, dst + total, count);
+
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error{errno, std::generic_category(),
+                              "npy_load_fd: read() failed"};
+    } else if (n == 0) {
+      break;
+    }
+
+    total += n;
+  }
+
+  return total;
+}
+
+cnpypp::NpyArray cnpypp::npy_load_fd(int fd) {
+  std::vector<std::byte> header(10);
+
+  if (read_fully(fd, header.data(), header.size()) != header.size()) {
+    throw std::runtime_error("npy_load_fd: unexpected end of stream");
+  }
+
+  uint16_t const header_len =
+      boost::endian::endian_load<boost::uint16_t, 2,
+                                 boost::endian::order::little>(
+          reinterpret_cast<unsigned char const*>(header.data() + 8));
+
+  header.resize(10 + header_len);
+
+  if (read_fully(fd, header.data() + 10, header_len) != header_len) {
+    throw std::runtime_error("npy_load_fd: unexpected end of stream");
+  }
+
+  std::vector<size_t> word_sizes, shape;
+  std::vector<char> data_types;
+  std::vector<std::string> labels;
+  std::vector<std::vector<size_t>> field_shapes;
+  cnpypp::MemoryOrder memory_order;
+
+  cnpypp::parse_npy_header(
+      cnpypp::span<char const>{reinterpret_cast<char const*>(header.data()),
+                               header.size()},
+      word_sizes, data_types, labels, field_shapes, shape, memory_order);
+
+  auto const num_vals = std::accumulate(shape.begin(), shape.end(), size_t{1},
+                                        std::multiplies<size_t>());
+  auto const total_value_size = std::accumulate(
+      word_sizes.begin(), word_sizes.end(), size_t{0}, std::plus<size_t>());
+  auto const num_bytes = total_value_size * num_vals;
+
+  auto buffer = std::make_unique<InMemoryBuffer>(num_bytes);
+
+  if (read_fully(fd, buffer->data(), num_bytes) != num_bytes) {
+    throw std::runtime_error("npy_load_fd: unexpected end of stream");
+  }
+
+  return cnpypp::NpyArray{std::move(shape), std::move(word_sizes),
+                          std::move(data_types), std::move(labels),
+                          std::move(field_shapes), memory_order,
+                          std::move(buffer)};
+}
+#endif
+
+cnpypp::NpyArray cnpypp::npy_load_from(cnpypp::span<std::byte const> buffer) {
+  return npy_load_from(buffer, {});
+}
+
+cnpypp::NpyArray cnpypp::npy_load_from(cnpypp::span<std::byte const> buffer,
+                                       std::function<void()> release) {
+  std::vector<size_t> word_sizes, shape;
+  std::vector<char> data_types;
+  std::vector<std::string> labels;
+  std::vector<std::vector<size_t>> field_shapes;
+  cnpypp::MemoryOrder memory_order;
+
+  size_t const offset = cnpypp::parse_npy_header(
+      cnpypp::span<char const>{reinterpret_cast<char const*>(buffer.data()),
+                               buffer.size()},
+      word_sizes, data_types, labels, field_shapes, shape, memory_order);
+
+  auto const num_vals = std::accumulate(shape.begin(), shape.end(), size_t{1},
+                                        std::multiplies<size_t>());
+  auto const total_value_size = std::accumulate(
+      word_sizes.begin(), word_sizes.end(), size_t{0}, std::plus<size_t>());
+
+  if (total_value_size != 0 &&
+      num_vals > (buffer.size() - offset) / total_value_size) {
+    throw std::runtime_error("npy_load_from: data exceed buffer");
+  }
+
+  // the non-const accessors of NpyArray must not be used to write to
+  // read-only memory
+  auto external = std::make_unique<ExternalBuffer>(
+      const_cast<std::byte*>(buffer.data()) + offset, std::move(release));
+
+  return cnpypp::NpyArray{std::move(shape), std::move(word_sizes),
+                          std::move(data_types), std::move(labels),
+                          std::move(field_shapes), memory_order,
+                          std::move(external)};
+}
+
+cnpypp::NpyArray cnpypp::npy_load(std::string const& fname,
+                                  MemoryOrder desired) {
   std::ifstream fs{fname, std::ios::binary};
 
   if (!fs)
@@ -367,10 +875,11 @@ cnpypp::NpyArray cnpypp::npy_load(std::string const& fname,
   std::vector<size_t> word_sizes, shape;
   std::vector<char> data_types;
   std::vector<std::string> labels;
+  std::vector<std::vector<size_t>> field_shapes;
   cnpypp::MemoryOrder memory_order;
 
-  cnpypp::parse_npy_header(fs, word_sizes, data_types, labels, shape,
-                           memory_order);
+  cnpypp::parse_npy_header(fs, word_sizes, data_types, labels, field_shapes,
+                           shape, memory_order);
 
   auto const num_vals = std::accumulate(shape.begin(), shape.end(), size_t{1},
                                         std::multiplies<size_t>());
@@ -378,17 +887,232 @@ cnpypp::NpyArray cnpypp::npy_load(std::string const& fname,
       word_sizes.begin(), word_sizes.end(), size_t{0}, std::plus<size_t>());
   auto const num_bytes = total_value_size * num_vals;
 
-  std::unique_ptr<Buffer> buffer;
+  auto buffer = std::make_unique<InMemoryBuffer>(num_bytes);
 
-  if (!memory_mapped) {
-    buffer = std::make_unique<InMemoryBuffer>(num_bytes);
+  // for rank < 2 both memory orders have the same layout
+  if (memory_order == desired || shape.size() < 2 || num_bytes == 0) {
     fs.read(reinterpret_cast<char*>(buffer->data()), num_bytes);
   } else {
-    buffer = std::make_unique<MemoryMappedBuffer>(fname, fs.tellg(), num_bytes);
+    // transpose directly from the page cache into the result
+    MemoryMappedBuffer const source{fname, static_cast<size_t>(fs.tellg()),
+                                    num_bytes};
+    transpose_memory_order(source.data(), buffer->data(), shape,
+                           total_value_size, memory_order);
   }
 
   return cnpypp::NpyArray{std::move(shape), std::move(word_sizes),
-                          std::move(labels), memory_order, std::move(buffer)};
+                          std::move(data_types), std::move(labels),
+                          std::move(field_shapes), desired,
+                          std::move(buffer)};
+}
+
+cnpypp::NpyArray
+cnpypp::npy_load_columns(std::string const& fname,
+                         std::vector<std::string_view> const& names) {
+  std::ifstream fs{fname, std::ios::binary};
+
+  if (!fs)
+    throw std::runtime_error("npy_load_columns: Unable to open file " + fname);
+
+  std::vector<size_t> word_sizes, shape;
+  std::vector<char> data_types;
+  std::vector<std::string> labels;
+  std::vector<std::vector<size_t>> field_shapes;
+  cnpypp::MemoryOrder memory_order;
+
+  cnpypp::parse_npy_header(fs, word_sizes, data_types, labels, field_shapes,
+                           shape, memory_order);
+
+  if (labels.empty()) {
+    throw std::runtime_error("npy_load_columns: " + fname +
+                             " does not contain a structured array");
+  }
+
+  std::vector<size_t> field_offsets(word_sizes.size());
+  std::exclusive_scan(word_sizes.begin(), word_sizes.end(),
+                      field_offsets.begin(), size_t{0});
+  size_t const record_size = field_offsets.back() + word_sizes.back();
+
+  // byte ranges copied per record; fields adjacent in both the file and the
+  // result are copied at once
+  struct copy_run {
+    size_t src_offset, dst_offset, size;
+  };
+  std::vector<copy_run> runs;
+
+  std::vector<size_t> sel_word_sizes;
+  std::vector<char> sel_data_types;
+  std::vector<std::string> sel_labels;
+  std::vector<std::vector<size_t>> sel_field_shapes;
+  size_t sel_record_size = 0;
+
+  for (auto const name : names) {
+    auto const it = std::find(labels.cbegin(), labels.cend(), name);
+    if (name.empty() || it == labels.cend()) {
+      throw std::runtime_error("npy_load_columns: field \"" +
+                               std::string{name} + "\" not found");
+    } else if (std::find(sel_labels.cbegin(), sel_labels.cend(), name) !=
+               sel_labels.cend()) {
+      throw std::runtime_error("npy_load_columns: field \"" +
+                               std::string{name} + "\" selected twice");
+    }
+
+    size_t const i = std::distance(labels.cbegin(), it);
+
+    if (!runs.empty() &&
+        runs.back().src_offset + runs.back().size == field_offsets[i]) {
+      runs.back().size += word_sizes[i];
+    } else {
+      runs.push_back({field_offsets[i], sel_record_size, word_sizes[i]});
+    }
+
+    sel_record_size += word_sizes[i];
+    sel_word_sizes.push_back(word_sizes[i]);
+    sel_data_types.push_back(data_types[i]);
+    sel_labels.push_back(labels[i]);
+    sel_field_shapes.push_back(field_shapes[i]);
+  }
+
+  if (sel_labels.size() == 1 && sel_field_shapes[0].empty()) {
+    sel_labels.clear();
+    sel_field_shapes.clear();
+  }
+
+  auto const num_vals = std::accumulate(shape.begin(), shape.end(), size_t{1},
+                                        std::multiplies<size_t>());
+  auto buffer = std::make_unique<InMemoryBuffer>(num_vals * sel_record_size);
+
+  if (num_vals > 0 && sel_record_size > 0) {
+    MemoryMappedBuffer source{fname, static_cast<size_t>(fs.tellg()),
+                              num_vals * record_size, MapHint::sequential};
+
+    // records per block, such that about 4 MiB of the file are processed at
+    // once and dropped from the mapping afterwards
+    size_t const block_size =
+        std::max(size_t{1}, (size_t{4} << 20) / record_size);
+
+    for (size_t first = 0; first < num_vals; first += block_size) {
+      size_t const n = std::min(block_size, num_vals - first);
+      std::byte const* src = source.data() + first * record_size;
+      std::byte* dst = buffer->data() + first * sel_record_size;
+
+      for (size_t k = 0; k < n; ++k) {
+        for (auto const& run : runs) {
+          std::memcpy(dst + run.dst_offset, src + run.src_offset, run.size);
+        }
+        src += record_size;
+        dst += sel_record_size;
+      }
+
+      source.evict(first * record_size, n * record_size);
+    }
+  }
+
+  return cnpypp::NpyArray{std::move(shape), std::move(sel_word_sizes),
+                          std::move(sel_data_types), std::move(sel_labels),
+                          std::move(sel_field_shapes), memory_order,
+                          std::move(buffer)};
+}
+
+// bools per chunk when packing or unpacking file data, a multiple of 8
+static size_t constexpr bit_chunk_size = size_t{1} << 20;
+
+cnpypp::PackedBitArray cnpypp::npy_load_packed(std::string const& fname,
+                                               size_t count, BitOrder order) {
+  std::ifstream fs{fname, std::ios::binary};
+
+  if (!fs)
+    throw std::runtime_error("npy_load_packed: Unable to open file " + fname);
+
+  std::vector<size_t> word_sizes, shape;
+  std::vector<char> data_types;
+  std::vector<std::string> labels;
+  std::vector<std::vector<size_t>> field_shapes;
+  cnpypp::MemoryOrder memory_order;
+
+  cnpypp::parse_npy_header(fs, word_sizes, data_types, labels, field_shapes,
+                           shape, memory_order);
+
+  if (!labels.empty() || word_sizes.at(0) != 1 ||
+      (data_types.at(0) != 'b' && data_types.at(0) != 'u')) {
+    throw std::runtime_error(
+        "npy_load_packed: only bool and uint8 arrays supported");
+  }
+
+  auto const num_vals = std::accumulate(shape.begin(), shape.end(), size_t{1},
+                                        std::multiplies<size_t>());
+
+  size_t const available = data_types[0] == 'u' ? 8 * num_vals : num_vals;
+  size_t const size = std::min(count, available);
+  if (count != std::numeric_limits<size_t>::max() && count != size) {
+    throw std::runtime_error(
+        "npy_load_packed: count exceeds the number of bits in " + fname);
+  }
+
+  // bools are packed in storage order, i.e. like np.packbits(a.ravel('A')),
+  // and only the first size of them are read
+  size_t const num_bytes = data_types[0] == 'u' ? num_vals : (size + 7) / 8;
+
+  auto buffer = std::make_unique<InMemoryBuffer>(num_bytes);
+  auto* const dst = reinterpret_cast<uint8_t*>(buffer->data());
+
+  if (data_types[0] == 'u') {
+    fs.read(reinterpret_cast<char*>(dst), num_bytes);
+  } else {
+    auto chunk = std::make_unique<bool[]>(std::min(size, bit_chunk_size));
+
+    for (size_t done = 0; done < size && fs;) {
+      size_t const n = std::min(size - done, bit_chunk_size);
+      fs.read(reinterpret_cast<char*>(chunk.get()), n);
+      pack_bits(chunk.get(), n, dst + done / 8, order);
+      done += n;
+    }
+  }
+
+  if (!fs) {
+    throw std::runtime_error("npy_load_packed: unexpected end of file " +
+                             fname);
+  }
+
+  return PackedBitArray{
+      NpyArray{{num_bytes}, {1}, {'u'}, {}, {}, MemoryOrder::C,
+               std::move(buffer)},
+      size, order};
+}
+
+void cnpypp::npy_save_packed(std::string const& fname, bit_view bits) {
+  size_t const shape[] = {bits.num_bytes()};
+  auto fs = open_npy_for_writing<uint8_t>(fname, shape, "w", MemoryOrder::C);
+
+  size_t const full = bits.size() / 8;
+  fs.write(reinterpret_cast<char const*>(bits.data()), full);
+
+  if (full != bits.num_bytes()) {
+    char const last =
+        bits.data()[full] & detail::tail_mask(bits.size(), bits.order());
+    fs.put(last);
+  }
+
+  if (!fs) {
+    throw std::runtime_error("npy_save_packed: Unable to write file " + fname);
+  }
+}
+
+void cnpypp::npy_save_unpacked(std::string const& fname, bit_view bits) {
+  size_t const shape[] = {bits.size()};
+  auto fs = open_npy_for_writing<bool>(fname, shape, "w", MemoryOrder::C);
+  auto chunk = std::make_unique<bool[]>(std::min(bits.size(), bit_chunk_size));
+
+  for (size_t done = 0; done < bits.size(); done += bit_chunk_size) {
+    size_t const n = std::min(bits.size() - done, bit_chunk_size);
+    bits.unpack(done, n, chunk.get());
+    fs.write(reinterpret_cast<char const*>(chunk.get()), n);
+  }
+
+  if (!fs) {
+    throw std::runtime_error("npy_save_unpacked: Unable to write file " +
+                             fname);
+  }
 }
 
 std::vector<char>
@@ -397,11 +1121,22 @@ cnpypp::create_npy_header(cnpypp::span<size_t const> const shape,
                           cnpypp::span<char const> dtypes,
                           cnpypp::span<size_t const> sizes,
                           MemoryOrder memory_order) {
+  return create_npy_header(shape, labels, dtypes, sizes, {}, memory_order);
+}
+
+std::vector<char>
+cnpypp::create_npy_header(cnpypp::span<size_t const> const shape,
+                          cnpypp::span<std::string_view const> labels,
+                          cnpypp::span<char const> dtypes,
+                          cnpypp::span<size_t const> sizes,
+                          cnpypp::span<std::vector<size_t> const> field_shapes,
+                          MemoryOrder memory_order) {
   std::vector<char> dict;
   append(dict, "{'descr': [");
 
   if (labels.size() != dtypes.size() || dtypes.size() != sizes.size() ||
-      sizes.size() != labels.size()) {
+      sizes.size() != labels.size() ||
+      (!field_shapes.empty() && field_shapes.size() != labels.size())) {
     throw std::runtime_error(
         "create_npy_header: sizes of argument vectors not equal");
   }
@@ -409,15 +1144,38 @@ cnpypp::create_npy_header(cnpypp::span<size_t const> const shape,
   for (size_t i = 0; i < dtypes.size(); ++i) {
     auto const& label = labels[i];
     auto const& dtype = dtypes[i];
-    auto const& size = sizes[i];
+    auto size = sizes[i];
+
+    std::vector<size_t> const no_shape;
+    auto const& field_shape = field_shapes.empty() ? no_shape : field_shapes[i];
+    size_t const count = num_elements(field_shape);
+
+    if (count == 0 || size % count != 0) {
+      throw std::runtime_error(
+          "create_npy_header: size does not match sub-array shape");
+    }
+    size /= count;
 
     append(dict, "('");
     append(dict, label);
     append(dict, "', '");
-    dict.push_back(BigEndianTest());
-    dict.push_back(dtype);
-    append(dict, std::to_string(size));
-    append(dict, "')");
+    append_descr(dict, dtype, size);
+    dict.push_back('\'');
+
+    if (!field_shape.empty()) {
+      append(dict, ", (");
+      append(dict, std::to_string(field_shape[0]));
+      for (size_t k = 1; k < field_shape.size(); ++k) {
+        append(dict, ", ");
+        append(dict, std::to_string(field_shape[k]));
+      }
+      if (field_shape.size() == 1) {
+        append(dict, ",");
+      }
+      append(dict, ")");
+    }
+
+    dict.push_back(')');
 
     if (i + 1 != dtypes.size()) {
       append(dict, ", ");
@@ -431,9 +1189,10 @@ cnpypp::create_npy_header(cnpypp::span<size_t const> const shape,
   append(dict, "], 'fortran_order': ");
   append(dict, (memory_order == MemoryOrder::C) ? "False" : "True");
   append(dict, ", 'shape': (");
-  append(dict, std::to_string(shape[0]));
-  for (size_t i = 1; i < shape.size(); i++) {
-    append(dict, ", ");
+  for (size_t i = 0; i < shape.size(); i++) {
+    if (i > 0) {
+      append(dict, ", ");
+    }
     append(dict, std::to_string(shape[i]));
   }
   if (shape.size() == 1) {
@@ -458,20 +1217,130 @@ cnpypp::create_npy_header(cnpypp::span<size_t const> const shape,
   return header;
 }
 
+void cnpypp::pad_npy_header(std::vector<char>& header, size_t size) {
+  if (header.size() > size || size - 10 > 0xffff) {
+    throw std::runtime_error("pad_npy_header: invalid header size");
+  }
+
+  header.insert(header.end() - 1, size - header.size(), ' ');
+  header[8] = static_cast<char>((size - 10) & 0xff);
+  header[9] = static_cast<char>((size - 10) >> 8);
+}
+
+size_t cnpypp::growable_npy_header_size(cnpypp::span<size_t const> row_shape,
+                                        char dtype, size_t size) {
+  std::vector<size_t> shape{std::numeric_limits<size_t>::max()};
+  shape.insert(shape.end(), row_shape.begin(), row_shape.end());
+
+  return (create_npy_header(shape, dtype, size).size() + 63) / 64 * 64;
+}
+
+std::fstream cnpypp::open_npy_for_writing(
+    std::string const& fname, cnpypp::span<size_t const> const shape,
+    cnpypp::span<std::string_view const> labels,
+    cnpypp::span<char const> dtypes, cnpypp::span<size_t const> sizes,
+    cnpypp::span<std::vector<size_t> const> field_shapes, std::string_view mode,
+    MemoryOrder memory_order) {
+  std::fstream fs;
+  std::vector<size_t>
+      true_data_shape; // if appending, the shape of existing + new data
+
+  if (mode == "a" && _exists(fname)) {
+    // file exists. we need to append to it. read the header, modify the array
+    // size
+    fs.open(fname,
+            std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+
+    std::vector<size_t> word_sizes_exist;
+    std::vector<char> data_types_exist;
+    std::vector<std::string> labels_exist;
+    std::vector<std::vector<size_t>> field_shapes_exist;
+    cnpypp::MemoryOrder memory_order_exist;
+
+    parse_npy_header(fs, word_sizes_exist, data_types_exist, labels_exist,
+                     field_shapes_exist, true_data_shape, memory_order_exist);
+
+    if (labels.size() != labels_exist.size()) {
+      throw std::runtime_error{"libcnpy++ error in npy_save(): appending "
+                               "failed: sizes not matching"};
+    }
+    if (!std::equal(data_types_exist.cbegin(), data_types_exist.cend(),
+                    dtypes.begin())) {
+      throw std::runtime_error{"libcnpy++ error in npy_save(): appending "
+                               "failed: data type descriptors not matching"};
+    }
+    if (!std::equal(word_sizes_exist.cbegin(), word_sizes_exist.cend(),
+                    sizes.begin())) {
+      throw std::runtime_error{"libcnpy++ error in npy_save(): appending "
+                               "failed: element sizes not matching"};
+    }
+    for (size_t i = 0; i < field_shapes.size(); ++i) {
+      if (field_shapes[i] != field_shapes_exist.at(i)) {
+        throw std::runtime_error{"libcnpy++ error in npy_save(): appending "
+                                 "failed: sub-array shapes not matching"};
+      }
+    }
+
+    if (memory_order != memory_order_exist) {
+      throw std::runtime_error{
+          "libcnpy++ error in npy_save(): memory order does not match"};
+    }
+
+    if (true_data_shape.size() != shape.size()) {
+      std::stringstream ss;
+      ss << "libcnpy++ error: npy_save attempting to append misdimensioned "
+            "data to "
+         << std::quoted(fname);
+      throw std::runtime_error{ss.str().c_str()};
+    }
+
+    // data are appended along the slowest-varying axis
+    bool const shape_matches =
+        (memory_order == MemoryOrder::C)
+            ? std::equal(std::next(shape.begin()), shape.end(),
+                         std::next(true_data_shape.begin()))
+            : std::equal(shape.begin(), std::prev(shape.end()),
+                         true_data_shape.begin());
+    if (!shape.empty() && !shape_matches) {
+      std::stringstream ss;
+      ss << "libcnpy++ error: npy_save attempting to append misshaped data to "
+         << std::quoted(fname);
+      throw std::runtime_error{ss.str().c_str()};
+    }
+
+    if (memory_order == MemoryOrder::C)
+      true_data_shape.front() += shape.front();
+    else
+      true_data_shape.back() += shape.back();
+
+  } else { // write mode
+    fs.open(fname, std::ios_base::binary | std::ios_base::out);
+    true_data_shape = std::vector<size_t>{shape.begin(), shape.end()};
+  }
+
+  auto const header = create_npy_header(true_data_shape, labels, dtypes, sizes,
+                                       field_shapes, memory_order);
+
+  fs.seekp(0, std::ios_base::beg);
+  fs.write(&header[0], sizeof(char) * header.size());
+  fs.seekp(0, std::ios_base::end);
+
+  return fs;
+}
+
 std::vector<char>
 cnpypp::create_npy_header(cnpypp::span<size_t const> const shape, char dtype,
                           int wordsize, MemoryOrder memory_order) {
   std::vector<char> dict;
   append(dict, "{'descr': '");
-  dict += BigEndianTest();
-  dict.push_back(dtype);
-  append(dict, std::to_string(wordsize));
+  append_descr(dict, dtype, wordsize);
   append(dict, "', 'fortran_order': ");
   append(dict, (memory_order == MemoryOrder::C) ? "False" : "True");
   append(dict, ", 'shape': (");
-  append(dict, std::to_string(shape[0]));
-  for (size_t i = 1; i < shape.size(); i++) {
-    append(dict, ", ");
+  for (size_t i = 0; i < shape.size(); i++) {
+    if (i > 0) {
+      append(dict, ", ");
+    }
     append(dict, std::to_string(shape[i]));
   }
   if (shape.size() == 1) {
@@ -496,6 +1365,55 @@ cnpypp::create_npy_header(cnpypp::span<size_t const> const shape, char dtype,
   return header;
 }
 
+// calls f with a value-initialized object of the type corresponding to
+// dtype, returns false for unknown types
+template <typename F>
+static bool dispatch_data_type(cnpypp_data_type dtype, F&& f) {
+  switch (dtype) {
+  case cnpypp_int8:
+    f(int8_t{});
+    return true;
+  case cnpypp_uint8:
+    f(uint8_t{});
+    return true;
+  case cnpypp_int16:
+    f(int16_t{});
+    return true;
+  case cnpypp_uint16:
+    f(uint16_t{});
+    return true;
+  case cnpypp_int32:
+    f(int32_t{});
+    return true;
+  case cnpypp_uint32:
+    f(uint32_t{});
+    return true;
+  case cnpypp_int64:
+    f(int64_t{});
+    return true;
+  case cnpypp_uint64:
+    f(uint64_t{});
+    return true;
+  case cnpypp_float32:
+    f(float{});
+    return true;
+  case cnpypp_float64:
+    f(double{});
+    return true;
+  case cnpypp_float128:
+    f(0.0L);
+    return true;
+  case cnpypp_float16:
+    f(cnpypp::float16{});
+    return true;
+  case cnpypp_bfloat16:
+    f(cnpypp::bfloat16{});
+    return true;
+  }
+
+  return false;
+}
+
 // for C compatibility
 int cnpypp_npy_save(char const* fname, cnpypp_data_type dtype,
                     void const* start, size_t const* shape, size_t rank,
@@ -507,63 +1425,13 @@ int cnpypp_npy_save(char const* fname, cnpypp_data_type dtype,
     shapeVec.reserve(rank);
     std::copy_n(shape, rank, std::back_inserter(shapeVec));
 
-    switch (dtype) {
-    case cnpypp_int8:
-      cnpypp::npy_save(filename, reinterpret_cast<int8_t const*>(start),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_uint8:
-      cnpypp::npy_save(filename, reinterpret_cast<uint8_t const*>(start),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_int16:
-      cnpypp::npy_save(filename, reinterpret_cast<int16_t const*>(start),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_uint16:
-      cnpypp::npy_save(filename, reinterpret_cast<uint16_t const*>(start),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_int32:
-      cnpypp::npy_save(filename, reinterpret_cast<int32_t const*>(start),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_uint32:
-      cnpypp::npy_save(filename, reinterpret_cast<uint32_t const*>(start),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_int64:
-      cnpypp::npy_save(filename, reinterpret_cast<int64_t const*>(start),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_uint64:
-      cnpypp::npy_save(filename, reinterpret_cast<uint64_t const*>(start),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_float32:
-      cnpypp::npy_save(filename, reinterpret_cast<float const*>(start),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_float64:
-      cnpypp::npy_save(filename, reinterpret_cast<double const*>(start),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_float128:
-      cnpypp::npy_save(filename, reinterpret_cast<long double const*>(start),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    default:
+    // unknown types are only reported, the call still succeeds
+    if (!dispatch_data_type(dtype, [&](auto value) {
+          cnpypp::npy_save(filename,
+                           reinterpret_cast<decltype(value) const*>(start),
+                           shapeVec, mode,
+                           static_cast<cnpypp::MemoryOrder>(memory_order));
+        })) {
       std::cerr << "npy_save: unknown type argument" << std::endl;
     }
   } catch (...) {
@@ -584,63 +1452,13 @@ int cnpypp_npz_save(char const* zipname, char const* filename,
     shapeVec.reserve(rank);
     std::copy_n(shape, rank, std::back_inserter(shapeVec));
 
-    switch (dtype) {
-    case cnpypp_int8:
-      cnpypp::npz_save(zipname, filename, reinterpret_cast<int8_t const*>(data),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_uint8:
-      cnpypp::npz_save(zipname, filename,
-                       reinterpret_cast<uint8_t const*>(data), shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_int16:
-      cnpypp::npz_save(zipname, filename,
-                       reinterpret_cast<int16_t const*>(data), shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_uint16:
-      cnpypp::npz_save(zipname, filename,
-                       reinterpret_cast<uint16_t const*>(data), shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_int32:
-      cnpypp::npz_save(zipname, filename,
-                       reinterpret_cast<int32_t const*>(data), shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_uint32:
-      cnpypp::npz_save(zipname, filename,
-                       reinterpret_cast<uint32_t const*>(data), shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_int64:
-      cnpypp::npz_save(zipname, filename,
-                       reinterpret_cast<int64_t const*>(data), shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_uint64:
-      cnpypp::npz_save(zipname, filename,
-                       reinterpret_cast<uint64_t const*>(data), shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_float32:
-      cnpypp::npz_save(zipname, filename, reinterpret_cast<float const*>(data),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_float64:
-      cnpypp::npz_save(zipname, filename, reinterpret_cast<double const*>(data),
-                       shapeVec, mode,
-                       static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    case cnpypp_float128:
-      cnpypp::npz_save(zipname, filename,
-                       reinterpret_cast<long double const*>(data), shapeVec,
-                       mode, static_cast<cnpypp::MemoryOrder>(memory_order));
-      break;
-    default:
+    // unknown types are only reported, the call still succeeds
+    if (!dispatch_data_type(dtype, [&](auto value) {
+          cnpypp::npz_save(zipname, filename,
+                           reinterpret_cast<decltype(value) const*>(data),
+                           shapeVec, mode,
+                           static_cast<cnpypp::MemoryOrder>(memory_order));
+        })) {
       std::cerr << "npz_save: unknown type argument" << std::endl;
     }
   } catch (...) {
@@ -651,6 +1469,69 @@ int cnpypp_npz_save(char const* zipname, char const* filename,
 }
 #endif
 
+int cnpypp_npy_save_as(char const* fname, cnpypp_data_type dtype,
+                       void const* start, size_t const* shape, size_t rank,
+                       char const* mode, enum cnpypp_memory_order memory_order,
+                       cnpypp_data_type target_dtype) {
+  int retval = 0;
+  try {
+    std::string const filename = fname;
+    std::vector<size_t> const shapeVec(shape, shape + rank);
+
+    bool known_target = false;
+    bool const known_source = dispatch_data_type(dtype, [&](auto source) {
+      using source_type = decltype(source);
+
+      known_target = dispatch_data_type(target_dtype, [&](auto target) {
+        cnpypp::npy_save(filename, reinterpret_cast<source_type const*>(start),
+                         shapeVec, cnpypp::save_as<decltype(target)>, mode,
+                         static_cast<cnpypp::MemoryOrder>(memory_order));
+      });
+    });
+
+    if (!known_source || !known_target) {
+      retval = -1;
+    }
+  } catch (...) {
+    retval = -1;
+  }
+
+  return retval;
+}
+
+#ifndef NO_LIBZIP
+int cnpypp_npz_save_as(char const* zipname, char const* filename,
+                       enum cnpypp_data_type dtype, void const* data,
+                       size_t const* shape, size_t rank, char const* mode,
+                       enum cnpypp_memory_order memory_order,
+                       enum cnpypp_data_type target_dtype) {
+  int retval = 0;
+  try {
+    std::vector<size_t> const shapeVec(shape, shape + rank);
+
+    bool known_target = false;
+    bool const known_source = dispatch_data_type(dtype, [&](auto source) {
+      using source_type = decltype(source);
+
+      known_target = dispatch_data_type(target_dtype, [&](auto target) {
+        cnpypp::npz_save(zipname, filename,
+                         reinterpret_cast<source_type const*>(data), shapeVec,
+                         cnpypp::save_as<decltype(target)>, mode,
+                         static_cast<cnpypp::MemoryOrder>(memory_order));
+      });
+    });
+
+    if (!known_source || !known_target) {
+      retval = -1;
+    }
+  } catch (...) {
+    retval = -1;
+  }
+
+  return retval;
+}
+#endif
+
 cnpypp_npyarray_handle* cnpypp_load_npyarray(char const* fname) {
   cnpypp::NpyArray* arr = nullptr;
 
@@ -0,0 +1,321 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#include <cstddef>
+#include <cstdint>
+
+#include <cnpy++/convert.hpp>
+#include <cnpy++/half.hpp>
+
+#if (defined(__GNUC__) || defined(__clang__)) &&                               \
+    (defined(__x86_64__) || defined(__i386__))
+#define CNPYPP_X86_SIMD
+#include <immintrin.h>
+#if (defined(__clang__) && __clang_major__ >= 14) ||                           \
+    (!defined(__clang__) && __GNUC__ >= 12)
+#define CNPYPP_AVX512FP16
+#endif
+#endif
+
+using namespace cnpypp;
+
+static void convert_scalar(double const* src, size_t n, float* dst) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = static_cast<float>(src[i]);
+  }
+}
+
+static void convert_scalar(float const* src, size_t n, float16* dst) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = float16::from_bits(
+        detail::float_bits_to_half(detail::float_to_bits(src[i])));
+  }
+}
+
+static void convert_scalar(double const* src, size_t n, float16* dst) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = float16::from_bits(
+        detail::float_bits_to_half(detail::double_to_float_bits_odd(src[i])));
+  }
+}
+
+static void convert_scalar(float16 const* src, size_t n, float* dst) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = static_cast<float>(src[i]);
+  }
+}
+
+static void convert_scalar(float const* src, size_t n, bfloat16* dst) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = bfloat16::from_bits(
+        detail::float_bits_to_bfloat(detail::float_to_bits(src[i])));
+  }
+}
+
+static void convert_scalar(double const* src, size_t n, bfloat16* dst) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = bfloat16::from_bits(
+        detail::float_bits_to_bfloat(detail::double_to_float_bits_odd(src[i])));
+  }
+}
+
+static void convert_scalar(bfloat16 const* src, size_t n, float* dst) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = static_cast<float>(src[i]);
+  }
+}
+
+#ifdef CNPYPP_X86_SIMD
+__attribute__((target("avx512f"))) static void
+convert_avx512(double const* src, size_t n, float* dst) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    // the zero-masked form, as GCC warns about the undefined pass-through
+    // operand of _mm512_cvtpd_ps() (-Wmaybe-uninitialized)
+    _mm256_storeu_ps(dst + i, _mm512_maskz_cvtpd_ps(
+                                  __mmask8(0xff), _mm512_loadu_pd(src + i)));
+  }
+  convert_scalar(src + i, n - i, dst + i);
+}
+
+__attribute__((target("avx"))) static void
+convert_avx(double const* src, size_t n, float* dst) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i)));
+    _mm_storeu_ps(dst + i + 4, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i + 4)));
+  }
+  convert_scalar(src + i, n - i, dst + i);
+}
+
+__attribute__((target("avx,f16c"))) static void
+convert_f16c(float const* src, size_t n, float16* dst) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i const h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                                      _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+  }
+  convert_scalar(src + i, n - i, dst + i);
+}
+
+// compress 64-bit lane masks to 32-bit lanes
+__attribute__((target("avx"))) static __m128i narrow_mask(__m256d m) {
+  __m256 const s = _mm256_castpd_ps(m);
+  return _mm_castps_si128(_mm_shuffle_ps(_mm256_castps256_ps128(s),
+                                         _mm256_extractf128_ps(s, 1),
+                                         _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+// 4 doubles -> 4 floats rounded to odd (cf. detail::double_to_float_bits_odd)
+__attribute__((target("avx"))) static __m128 round_to_odd(__m256d d) {
+  __m256d const absmask = _mm256_castsi256_pd(_mm256_set1_epi64x(INT64_MAX));
+  __m128 const f = _mm256_cvtpd_ps(d);
+  __m256d const back = _mm256_cvtps_pd(f);
+
+  __m256d const away = _mm256_cmp_pd(_mm256_and_pd(back, absmask),
+                                     _mm256_and_pd(d, absmask), _CMP_GT_OQ);
+  __m256d const inexact = _mm256_cmp_pd(back, d, _CMP_NEQ_OQ);
+
+  __m128i bits = _mm_add_epi32(_mm_castps_si128(f), narrow_mask(away));
+  bits = _mm_or_si128(bits,
+                      _mm_and_si128(narrow_mask(inexact), _mm_set1_epi32(1)));
+  return _mm_castsi128_ps(bits);
+}
+
+__attribute__((target("avx,f16c"))) static void
+convert_f16c(double const* src, size_t n, float16* dst) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 const f = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(round_to_odd(_mm256_loadu_pd(src + i))),
+        round_to_odd(_mm256_loadu_pd(src + i + 4)), 1);
+    __m128i const h = _mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+  }
+  convert_scalar(src + i, n - i, dst + i);
+}
+
+__attribute__((target("avx,f16c"))) static void
+convert_f16c(float16 const* src, size_t n, float* dst) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i const h =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+  convert_scalar(src + i, n - i, dst + i);
+}
+
+// 8 floats (as integers) -> 8 bfloat16, cf. detail::float_bits_to_bfloat
+__attribute__((target("avx2"))) static __m128i to_bfloat(__m256i x) {
+  __m256i const one = _mm256_set1_epi32(1);
+  __m256i const lsb = _mm256_and_si256(_mm256_srli_epi32(x, 16), one);
+  __m256i const rounded = _mm256_srli_epi32(
+      _mm256_add_epi32(_mm256_add_epi32(x, _mm256_set1_epi32(0x7fff)), lsb),
+      16);
+
+  __m256i const is_nan = _mm256_cmpgt_epi32(
+      _mm256_and_si256(x, _mm256_set1_epi32(0x7fffffff)),
+      _mm256_set1_epi32(0x7f800000));
+  __m256i const quiet_nan =
+      _mm256_or_si256(_mm256_srli_epi32(x, 16), _mm256_set1_epi32(0x40));
+
+  __m256i const b = _mm256_blendv_epi8(rounded, quiet_nan, is_nan);
+  __m256i const packed = _mm256_permute4x64_epi64(
+      _mm256_packus_epi32(b, b), _MM_SHUFFLE(3, 1, 2, 0));
+  return _mm256_castsi256_si128(packed);
+}
+
+__attribute__((target("avx2"))) static void
+convert_avx2(float const* src, size_t n, bfloat16* dst) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i const x = _mm256_castps_si256(_mm256_loadu_ps(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), to_bfloat(x));
+  }
+  convert_scalar(src + i, n - i, dst + i);
+}
+
+__attribute__((target("avx2"))) static void
+convert_avx2(double const* src, size_t n, bfloat16* dst) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 const f = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(round_to_odd(_mm256_loadu_pd(src + i))),
+        round_to_odd(_mm256_loadu_pd(src + i + 4)), 1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     to_bfloat(_mm256_castps_si256(f)));
+  }
+  convert_scalar(src + i, n - i, dst + i);
+}
+
+__attribute__((target("avx2"))) static void
+convert_avx2(bfloat16 const* src, size_t n, float* dst) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i const b = _mm256_cvtepu16_epi32(
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm256_slli_epi32(b, 16));
+  }
+  convert_scalar(src + i, n - i, dst + i);
+}
+#endif
+
+#ifdef CNPYPP_AVX512FP16
+__attribute__((target("avx512fp16,avx512vl"))) static void
+convert_avx512fp16(float const* src, size_t n, float16* dst) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256h const h = _mm512_cvtxps_ph(_mm512_loadu_ps(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm256_castph_si256(h));
+  }
+  convert_scalar(src + i, n - i, dst + i);
+}
+
+__attribute__((target("avx512fp16,avx512vl"))) static void
+convert_avx512fp16(double const* src, size_t n, float16* dst) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128h const h = _mm512_cvtpd_ph(_mm512_loadu_pd(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_castph_si128(h));
+  }
+  convert_scalar(src + i, n - i, dst + i);
+}
+
+__attribute__((target("avx512fp16,avx512vl"))) static void
+convert_avx512fp16(float16 const* src, size_t n, float* dst) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256h const h = _mm256_castsi256_ph(
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i)));
+    _mm512_storeu_ps(dst + i, _mm512_cvtxph_ps(h));
+  }
+  convert_scalar(src + i, n - i, dst + i);
+}
+#endif
+
+void cnpypp::convert(double const* src, size_t n, float* dst) {
+#ifdef CNPYPP_X86_SIMD
+  if (__builtin_cpu_supports("avx512f")) {
+    return convert_avx512(src, n, dst);
+  } else if (__builtin_cpu_supports("avx")) {
+    return convert_avx(src, n, dst);
+  }
+#endif
+  convert_scalar(src, n, dst);
+}
+
+void cnpypp::convert(float const* src, size_t n, float16* dst) {
+#ifdef CNPYPP_AVX512FP16
+  if (__builtin_cpu_supports("avx512fp16")) {
+    return convert_avx512fp16(src, n, dst);
+  }
+#endif
+#ifdef CNPYPP_X86_SIMD
+  if (__builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c")) {
+    return convert_f16c(src, n, dst);
+  }
+#endif
+  convert_scalar(src, n, dst);
+}
+
+void cnpypp::convert(double const* src, size_t n, float16* dst) {
+#ifdef CNPYPP_AVX512FP16
+  if (__builtin_cpu_supports("avx512fp16")) {
+    return convert_avx512fp16(src, n, dst);
+  }
+#endif
+#ifdef CNPYPP_X86_SIMD
+  if (__builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c")) {
+    return convert_f16c(src, n, dst);
+  }
+#endif
+  convert_scalar(src, n, dst);
+}
+
+void cnpypp::convert(float16 const* src, size_t n, float* dst) {
+#ifdef CNPYPP_AVX512FP16
+  if (__builtin_cpu_supports("avx512fp16")) {
+    return convert_avx512fp16(src, n, dst);
+  }
+#endif
+#ifdef CNPYPP_X86_SIMD
+  if (__builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c")) {
+    return convert_f16c(src, n, dst);
+  }
+#endif
+  convert_scalar(src, n, dst);
+}
+
+void cnpypp::convert(float const* src, size_t n, bfloat16* dst) {
+#ifdef CNPYPP_X86_SIMD
+  if (__builtin_cpu_supports("avx2")) {
+    return convert_avx2(src, n, dst);
+  }
+#endif
+  convert_scalar(src, n, dst);
+}
+
+void cnpypp::convert(double const* src, size_t n, bfloat16* dst) {
+#ifdef CNPYPP_X86_SIMD
+  if (__builtin_cpu_supports("avx2")) {
+    return convert_avx2(src, n, dst);
+  }
+#endif
+  convert_scalar(src, n, dst);
+}
+
+void cnpypp::convert(bfloat16 const* src, size_t n, float* dst) {
+#ifdef CNPYPP_X86_SIMD
+  if (__builtin_cpu_supports("avx2")) {
+    return convert_avx2(src, n, dst);
+  }
+#endif
+  convert_scalar(src, n, dst);
+}
@@ -0,0 +1,164 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+// the whole file relies on POSIX file descriptors and mmap()
+#ifdef CNPYPP_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static size_t constexpr default_reservation =
+    (sizeof(void*) >= 8) ? (size_t{1} << 40) : (size_t{1} << 30);
+static size_t constexpr initial_bytes = 0x100000; // 1 MiB
+
+static size_t const page_size = ::sysconf(_SC_PAGESIZE);
+
+static size_t round_to_pages(size_t size) {
+  return (size + page_size - 1) / page_size * page_size;
+}
+
+cnpypp::NpyGrowableArray::NpyGrowableArray(
+    std::string const& fname, cnpypp::span<size_t const> row_shape,
+    char data_type_, size_t word_size_, size_t max_bytes)
+    : fd{-1}, base{nullptr},
+      reserved{round_to_pages(max_bytes ? max_bytes : default_reservation)},
+      mapped{0},
+      header_size{growable_npy_header_size(row_shape, data_type_, word_size_)},
+      array_shape{0}, data_type{data_type_}, word_size{word_size_},
+      row_size{std::accumulate(row_shape.begin(), row_shape.end(), word_size_,
+                               std::multiplies<size_t>())} {
+  array_shape.insert(array_shape.end(), row_shape.begin(), row_shape.end());
+
+  // address space only, no memory or swap is committed
+  void* const addr = ::mmap(nullptr, reserved, PROT_NONE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+  if (addr == MAP_FAILED) {
+    throw std::system_error{errno, std::generic_category(),
+                            "NpyGrowableArray: could not reserve memory"};
+  }
+
+  base = static_cast<std::byte*>(addr);
+
+  fd = ::open(fname.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+
+  if (fd < 0) {
+    int const error = errno;
+    ::munmap(base, reserved);
+    throw std::system_error{error, std::generic_category(),
+                            "NpyGrowableArray: could not open " + fname};
+  }
+
+  try {
+    reserve(row_size ? std::max(size_t{1}, initial_bytes / row_size) : 0);
+    write_header();
+  } catch (...) {
+    ::munmap(base, reserved);
+    ::close(fd);
+    throw;
+  }
+}
+
+cnpypp::NpyGrowableArray::NpyGrowableArray(NpyGrowableArray&& other)
+    : fd{std::exchange(other.fd, -1)},
+      base{std::exchange(other.base, nullptr)}, reserved{other.reserved},
+      mapped{other.mapped}, header_size{other.header_size},
+      array_shape{other.array_shape}, data_type{other.data_type},
+      word_size{other.word_size}, row_size{other.row_size} {}
+
+cnpypp::NpyGrowableArray::~NpyGrowableArray() {
+  if (base != nullptr) {
+    ::munmap(base, reserved);
+  }
+
+  if (fd >= 0) {
+    // drop the unused capacity
+    if (::ftruncate(fd, static_cast<off_t>(header_size +
+                                           array_shape[0] * row_size)) != 0) {
+      // nothing sensible to do in a destructor
+    }
+    ::close(fd);
+  }
+}
+
+// makes sure that the file and the mapping can hold num_rows rows
+void cnpypp::NpyGrowableArray::reserve(size_t num_rows) {
+  size_t const required = header_size + num_rows * row_size;
+
+  if (required <= mapped && mapped > 0) {
+    return;
+  } else if (required > reserved) {
+    throw std::runtime_error(
+        "NpyGrowableArray: size exceeds reserved address space");
+  }
+
+  size_t const new_size =
+      std::min(reserved, round_to_pages(std::max(required, 2 * mapped)));
+
+  if (::ftruncate(fd, static_cast<off_t>(new_size)) != 0) {
+    throw std::system_error{errno, std::generic_category(),
+                            "NpyGrowableArray: ftruncate() failed"};
+  }
+
+  // replaces the previous mapping (and part of the reservation) in place,
+  // so that the addresses of existing data do not change
+  if (::mmap(base, new_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+             fd, 0) == MAP_FAILED) {
+    throw std::system_error{errno, std::generic_category(),
+                            "NpyGrowableArray: mmap() failed"};
+  }
+
+  mapped = new_size;
+}
+
+void cnpypp::NpyGrowableArray::write_header() {
+  std::vector<char> header =
+      create_npy_header(array_shape, data_type, word_size, MemoryOrder::C);
+  pad_npy_header(header, header_size);
+  std::memcpy(base, header.data(), header.size());
+}
+
+void cnpypp::NpyGrowableArray::append(std::byte const* data,
+                                      size_t num_rows) {
+  size_t const begin = array_shape[0];
+  reserve(begin + num_rows);
+  std::memcpy(base + header_size + begin * row_size, data,
+              num_rows * row_size);
+  array_shape[0] = begin + num_rows;
+  write_header();
+}
+
+void cnpypp::NpyGrowableArray::resize(size_t num_rows) {
+  size_t const old_rows = array_shape[0];
+  reserve(num_rows);
+
+  if (num_rows > old_rows) {
+    std::memset(base + header_size + old_rows * row_size, 0,
+                (num_rows - old_rows) * row_size);
+  }
+
+  array_shape[0] = num_rows;
+  write_header();
+}
+
+void cnpypp::NpyGrowableArray::sync() {
+  if (::msync(base, header_size + array_shape[0] * row_size, MS_SYNC) != 0) {
+    throw std::system_error{errno, std::generic_category(),
+                            "NpyGrowableArray: msync() failed"};
+  }
+}
+#endif
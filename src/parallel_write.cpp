@@ -0,0 +1,487 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+#ifdef CNPYPP_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+
+// payload chunks end at multiples of this file offset, so that all writes
+// but the first and last are aligned to page (and typical stripe) boundaries
+static size_t constexpr chunk_bytes = 0x800000; // 8 MiB
+
+// writes size bytes from data at offset, returns 0 or errno
+static int pwrite_fully(int fd, std::byte const* data, size_t size,
+                        off_t offset) {
+  while (size > 0) {
+    ssize_t const n =
+        ::pwrite(fd, data, std::min(size, size_t{1} << 30), offset);
+
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno;
+    } else if (n == 0) {
+      return EIO; // no progress, e.g. on a full device
+    }
+
+    data += n;
+    size -= n;
+    offset += n;
+  }
+
+  return 0;
+}
+
+// reserves size bytes for fd so that concurrent writers do not contend on
+// extending the file; falls back to a sparse file if not supported
+static int preallocate(int fd, size_t size) {
+  if (size == 0) {
+    return 0;
+  }
+
+#ifdef __linux__
+  if (::fallocate(fd, 0, 0, static_cast<off_t>(size)) == 0) {
+    return 0;
+  } else if (errno != EOPNOTSUPP) {
+    return errno;
+  }
+#else
+  if (::posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0) {
+    return 0;
+  }
+#endif
+
+  return (::ftruncate(fd, static_cast<off_t>(size)) == 0) ? 0 : errno;
+}
+
+void cnpypp::write_parallel(std::string const& fname,
+                            std::vector<char> const& header,
+                            std::byte const* payload, size_t payload_size,
+                            unsigned num_threads) {
+  int const fd = ::open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                        0666);
+
+  if (fd < 0) {
+    throw std::system_error{errno, std::generic_category(),
+                            "write_parallel: could not open " + fname};
+  }
+
+  size_t const header_size = header.size();
+  size_t const total_size = header_size + payload_size;
+
+  if (int const error = preallocate(fd, total_size)) {
+    ::close(fd);
+    throw std::system_error{error, std::generic_category(),
+                            "write_parallel: could not resize " + fname};
+  }
+
+  std::atomic<int> error{pwrite_fully(
+      fd, reinterpret_cast<std::byte const*>(header.data()), header_size, 0)};
+
+  size_t const num_chunks = (total_size + chunk_bytes - 1) / chunk_bytes;
+  std::atomic<size_t> next_chunk{0};
+
+  auto const worker = [&]() {
+    size_t chunk;
+
+    while (error.load(std::memory_order_relaxed) == 0 &&
+           (chunk = next_chunk.fetch_add(1, std::memory_order_relaxed)) <
+               num_chunks) {
+      size_t const begin = std::max(chunk * chunk_bytes, header_size);
+      size_t const end = std::min((chunk + 1) * chunk_bytes, total_size);
+
+      if (begin >= end) {
+        continue;
+      }
+
+      if (int const e = pwrite_fully(fd, payload + (begin - header_size),
+                                     end - begin, static_cast<off_t>(begin))) {
+        int expected = 0;
+        error.compare_exchange_strong(expected, e);
+      }
+    }
+  };
+
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = static_cast<unsigned>(
+      std::max<size_t>(1, std::min<size_t>(num_threads, num_chunks)));
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (unsigned t = 1; t < num_threads; ++t) {
+    threads.emplace_back(worker);
+  }
+  worker();
+
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  if (::close(fd) != 0 && error == 0) {
+    error = errno;
+  }
+
+  if (error != 0) {
+    throw std::system_error{error, std::generic_category(),
+                            "write_parallel: could not write " + fname};
+  }
+}
+#else
+// without pwrite() the header and payload are simply written in order
+void cnpypp::write_parallel(std::string const& fname,
+                            std::vector<char> const& header,
+                            std::byte const* payload, size_t payload_size,
+                            unsigned /* num_threads */) {
+  std::ofstream fs{fname, std::ios::binary | std::ios::trunc};
+  fs.write(header.data(), header.size());
+  fs.write(reinterpret_cast<char const*>(payload), payload_size);
+  fs.close();
+
+  if (!fs) {
+    throw std::runtime_error("write_parallel: could not write " + fname);
+  }
+}
+#endif
+
+#ifdef CNPYPP_POSIX
+cnpypp::NpyRowWriter::NpyRowWriter(int fd_, size_t data_offset_,
+                                   size_t num_rows_, size_t row_size_)
+    : fd{fd_}, data_offset{data_offset_}, num_rows{num_rows_},
+      row_size{row_size_} {}
+
+cnpypp::NpyRowWriter::NpyRowWriter(std::string const& fname) : fd{-1} {
+  std::ifstream fs{fname, std::ios::binary};
+
+  if (!fs) {
+    throw std::runtime_error("NpyRowWriter: Unable to open file " + fname);
+  }
+
+  std::vector<size_t> word_sizes, shape;
+  std::vector<char> data_types;
+  std::vector<std::string> labels;
+  std::vector<std::vector<size_t>> field_shapes;
+  cnpypp::MemoryOrder memory_order;
+
+  cnpypp::parse_npy_header(fs, word_sizes, data_types, labels, field_shapes,
+                           shape, memory_order);
+
+  if (memory_order != MemoryOrder::C && shape.size() > 1) {
+    throw std::runtime_error("NpyRowWriter: file is not in C order");
+  }
+
+  data_offset = fs.tellg();
+  num_rows = shape.empty() ? 1 : shape[0];
+  row_size = std::accumulate(word_sizes.begin(), word_sizes.end(), size_t{0},
+                             std::plus<size_t>());
+  if (!shape.empty()) {
+    row_size = std::accumulate(shape.begin() + 1, shape.end(), row_size,
+                               std::multiplies<size_t>());
+  }
+
+  fd = ::open(fname.c_str(), O_WRONLY | O_CLOEXEC);
+
+  if (fd < 0) {
+    throw std::system_error{errno, std::generic_category(),
+                            "NpyRowWriter: could not open " + fname};
+  }
+}
+
+cnpypp::NpyRowWriter::NpyRowWriter(NpyRowWriter&& other)
+    : fd{other.fd}, data_offset{other.data_offset}, num_rows{other.num_rows},
+      row_size{other.row_size} {
+  other.fd = -1;
+}
+
+cnpypp::NpyRowWriter::~NpyRowWriter() {
+  if (fd >= 0) {
+    ::close(fd);
+  }
+}
+
+void cnpypp::NpyRowWriter::write_rows(size_t begin_row, std::byte const* data,
+                                      size_t count) const {
+  if (begin_row > num_rows || count > num_rows - begin_row) {
+    throw std::runtime_error("write_rows: row range out of bounds");
+  }
+
+  off_t const offset = static_cast<off_t>(data_offset + begin_row * row_size);
+
+  if (int const error = pwrite_fully(fd, data, count * row_size, offset)) {
+    throw std::system_error{error, std::generic_category(),
+                            "write_rows: pwrite() failed"};
+  }
+}
+
+cnpypp::NpyRowWriter cnpypp::npy_create(std::string const& fname,
+                                        cnpypp::span<size_t const> shape,
+                                        char data_type, size_t word_size) {
+  std::vector<char> const header =
+      create_npy_header(shape, data_type, word_size, MemoryOrder::C);
+
+  size_t const num_rows = shape.empty() ? 1 : shape[0];
+  size_t const row_size =
+      shape.empty() ? word_size
+                    : std::accumulate(shape.begin() + 1, shape.end(),
+                                      word_size, std::multiplies<size_t>());
+
+  int const fd = ::open(fname.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+                        0666);
+
+  if (fd < 0) {
+    throw std::system_error{errno, std::generic_category(),
+                            "npy_create: could not open " + fname};
+  }
+
+  NpyRowWriter writer{fd, header.size(), num_rows, row_size};
+
+  if (int const error = preallocate(fd, header.size() + num_rows * row_size)) {
+    throw std::system_error{error, std::generic_category(),
+                            "npy_create: could not resize " + fname};
+  }
+
+  if (int const error =
+          pwrite_fully(fd, reinterpret_cast<std::byte const*>(header.data()),
+                       header.size(), 0)) {
+    throw std::system_error{error, std::generic_category(),
+                            "npy_create: could not write header to " + fname};
+  }
+
+  return writer;
+}
+
+// rows initially preallocated by NpyAppender; grows geometrically
+static size_t constexpr appender_initial_bytes = 0x100000; // 1 MiB
+
+struct cnpypp::NpyAppender::State {
+  // completed range of rows, pushed onto a lock-free stack by the producers
+  struct Range {
+    size_t begin, end;
+    Range* next;
+  };
+
+  int fd = -1;
+  std::vector<size_t> shape; // first entry is the number of committed rows
+  char data_type;
+  size_t word_size;
+  size_t row_size;
+  size_t header_size;
+
+  std::atomic<size_t> next_row{0};
+  std::atomic<size_t> allocated_rows{0};
+  std::atomic<Range*> completed{nullptr};
+  std::atomic_flag committing = ATOMIC_FLAG_INIT;
+
+  // only accessed by the thread holding committing
+  std::map<size_t, size_t> pending;
+
+  ~State() {
+    for (Range* r = completed.load(); r != nullptr;) {
+      Range* const next = r->next;
+      delete r;
+      r = next;
+    }
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  // header for the current shape, padded with spaces to header_size
+  std::vector<char> header() const {
+    std::vector<char> h =
+        create_npy_header(shape, data_type, word_size, MemoryOrder::C);
+    pad_npy_header(h, header_size);
+    return h;
+  }
+
+  void write_header() const {
+    std::vector<char> const h = header();
+
+    if (int const error = pwrite_fully(
+            fd, reinterpret_cast<std::byte const*>(h.data()), h.size(), 0)) {
+      throw std::system_error{error, std::generic_category(),
+                              "NpyAppender: could not write header"};
+    }
+  }
+
+  // extends the preallocated region to hold at least rows rows; concurrent
+  // callers race with CAS, only the winner preallocates
+  void reserve(size_t rows) {
+    size_t allocated = allocated_rows.load(std::memory_order_relaxed);
+
+    while (rows > allocated) {
+      size_t const target = std::max(rows, 2 * allocated);
+
+      if (allocated_rows.compare_exchange_weak(allocated, target,
+                                               std::memory_order_relaxed)) {
+#ifdef __linux__
+        // the file size is left unchanged, so that the file only contains
+        // rows that have been written; failure is harmless
+        ::fallocate(fd, FALLOC_FL_KEEP_SIZE,
+                    static_cast<off_t>(header_size + allocated * row_size),
+                    static_cast<off_t>((target - allocated) * row_size));
+#endif
+        break;
+      }
+    }
+  }
+
+  // requires committing to be held
+  size_t commit_locked() {
+    for (Range* r = completed.exchange(nullptr, std::memory_order_acquire);
+         r != nullptr;) {
+      pending.emplace(r->begin, r->end);
+      Range* const next = r->next;
+      delete r;
+      r = next;
+    }
+
+    size_t const before = shape[0];
+
+    for (auto it = pending.begin();
+         it != pending.end() && it->first == shape[0];
+         it = pending.erase(it)) {
+      shape[0] = it->second;
+    }
+
+    if (shape[0] != before) {
+      write_header();
+    }
+
+    return shape[0];
+  }
+
+  // commits unless another thread is already doing so. Ranges pushed while
+  // committing was held are picked up by checking again after clearing it:
+  // pushes and clears are sequentially consistent, so either the pushing
+  // thread sees committing cleared or the committing thread sees the range.
+  void commit_if_idle() {
+    while (completed.load() != nullptr && !committing.test_and_set()) {
+      try {
+        commit_locked();
+      } catch (...) {
+        committing.clear();
+        throw;
+      }
+      committing.clear();
+    }
+  }
+};
+
+cnpypp::NpyAppender::NpyAppender(std::string const& fname,
+                                 cnpypp::span<size_t const> row_shape,
+                                 char data_type, size_t word_size)
+    : state{std::make_unique<State>()} {
+  state->shape.push_back(0);
+  state->shape.insert(state->shape.end(), row_shape.begin(), row_shape.end());
+  state->data_type = data_type;
+  state->word_size = word_size;
+  state->row_size = std::accumulate(row_shape.begin(), row_shape.end(),
+                                    word_size, std::multiplies<size_t>());
+
+  state->header_size =
+      growable_npy_header_size(row_shape, data_type, word_size);
+
+  state->fd = ::open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                     0666);
+
+  if (state->fd < 0) {
+    throw std::system_error{errno, std::generic_category(),
+                            "NpyAppender: could not open " + fname};
+  }
+
+  state->write_header();
+
+  if (state->row_size > 0) {
+    state->reserve(
+        std::max(size_t{1}, appender_initial_bytes / state->row_size));
+  }
+}
+
+cnpypp::NpyAppender::NpyAppender(NpyAppender&&) = default;
+
+cnpypp::NpyAppender::~NpyAppender() {
+  if (state) {
+    try {
+      commit();
+    } catch (std::exception const&) {
+      // destructors must not throw
+    }
+  }
+}
+
+size_t cnpypp::NpyAppender::row_bytes() const { return state->row_size; }
+
+size_t cnpypp::NpyAppender::append(std::byte const* data, size_t num_rows) {
+  if (num_rows == 0) {
+    // an empty range would share its begin with the next one
+    return state->next_row.load(std::memory_order_relaxed);
+  }
+
+  size_t const begin =
+      state->next_row.fetch_add(num_rows, std::memory_order_relaxed);
+  size_t const end = begin + num_rows;
+
+  state->reserve(end);
+
+  off_t const offset =
+      static_cast<off_t>(state->header_size + begin * state->row_size);
+
+  if (int const error =
+          pwrite_fully(state->fd, data, num_rows * state->row_size, offset)) {
+    // the rows stay uncommitted, and so do all following ones
+    throw std::system_error{error, std::generic_category(),
+                            "NpyAppender: pwrite() failed"};
+  }
+
+  auto* const range = new State::Range{begin, end, nullptr};
+  range->next = state->completed.load(std::memory_order_relaxed);
+  while (!state->completed.compare_exchange_weak(range->next, range,
+                                                 std::memory_order_seq_cst,
+                                                 std::memory_order_relaxed)) {
+  }
+
+  // commit opportunistically unless another thread is already doing so
+  state->commit_if_idle();
+
+  return begin;
+}
+
+size_t cnpypp::NpyAppender::commit() {
+  while (state->committing.test_and_set()) {
+    std::this_thread::yield();
+  }
+
+  size_t rows;
+  try {
+    rows = state->commit_locked();
+  } catch (...) {
+    state->committing.clear();
+    throw;
+  }
+  state->committing.clear();
+
+  state->commit_if_idle(); // ranges pushed in the meantime
+  return rows;
+}
+#endif
@@ -0,0 +1,798 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <boost/endian/conversion.hpp>
+
+#include "cnpy++.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) &&                               \
+    (defined(__x86_64__) || defined(__i386__))
+#define CNPYPP_X86_SIMD
+#include <immintrin.h>
+#endif
+
+using namespace cnpypp;
+
+static size_t constexpr block_rows = 4096; // rows per block, multiple of 32
+static size_t constexpr block_words = block_rows / 32;
+
+// the whole range of T; infinite for floating-point types so that NaNs are
+// not contained
+template <typename T> static T lowest_value() {
+  if constexpr (std::is_integral_v<T>) {
+    return std::numeric_limits<T>::lowest();
+  } else {
+    return -std::numeric_limits<T>::infinity();
+  }
+}
+
+template <typename T> static T highest_value() {
+  if constexpr (std::is_integral_v<T>) {
+    return std::numeric_limits<T>::max();
+  } else {
+    return std::numeric_limits<T>::infinity();
+  }
+}
+
+// three-way comparison of integers of any types
+template <typename A, typename B> static int compare_integers(A a, B b) {
+  if constexpr (std::is_signed_v<A> && !std::is_signed_v<B>) {
+    if (a < 0) {
+      return -1;
+    }
+  } else if constexpr (!std::is_signed_v<A> && std::is_signed_v<B>) {
+    if (b < 0) {
+      return 1;
+    }
+  }
+
+  // both are non-negative or both signed now
+  using C = std::conditional_t<std::is_signed_v<A> && std::is_signed_v<B>,
+                               int64_t, uint64_t>;
+  C const x = static_cast<C>(a), y = static_cast<C>(b);
+  return (x < y) ? -1 : (x > y);
+}
+
+// exact three-way comparison of an integer with a floating-point value that
+// is not NaN; only values in the range of I are converted
+template <typename I, typename F>
+static int compare_integer_float(I a, F f) {
+  F const limit = std::ldexp(F{1}, std::numeric_limits<I>::digits);
+  if (f >= limit) {
+    return -1;
+  } else if (f < (std::is_signed_v<I> ? -limit : F{0})) {
+    return 1;
+  }
+
+  F const fl = std::floor(f);
+  I const i = static_cast<I>(fl);
+  if (a != i) {
+    return (a < i) ? -1 : 1;
+  }
+  return (fl == f) ? 0 : -1;
+}
+
+// exact three-way comparison of t with v, none if either is NaN
+template <typename T>
+static std::optional<int> compare(T t, ScanOperand const& v) {
+  if constexpr (std::is_floating_point_v<T>) {
+    if (std::isnan(t)) {
+      return std::nullopt;
+    }
+  }
+
+  if (v.kind == ScanOperand::Kind::Float) {
+    if (std::isnan(v.f)) {
+      return std::nullopt;
+    } else if constexpr (std::is_integral_v<T>) {
+      return compare_integer_float(t, v.f);
+    } else {
+      long double const x = t; // exact
+      return (x < v.f) ? -1 : (x > v.f);
+    }
+  }
+
+  auto const with = [t](auto n) {
+    if constexpr (std::is_integral_v<T>) {
+      return compare_integers(t, n);
+    } else {
+      return -compare_integer_float(n, t);
+    }
+  };
+  return (v.kind == ScanOperand::Kind::Signed) ? with(v.i) : with(v.u);
+}
+
+// a T next to v (i.e. no other T in between), with v clamped to the range of
+// T before any conversion; v must not be NaN
+template <typename T> static T approximate(ScanOperand const& v) {
+  if (v.kind == ScanOperand::Kind::Float) {
+    if constexpr (std::is_integral_v<T>) {
+      long double const limit =
+          std::ldexp(1.0L, std::numeric_limits<T>::digits);
+      if (v.f >= limit) {
+        return std::numeric_limits<T>::max();
+      } else if (v.f < (std::is_signed_v<T> ? -limit : 0.0L)) {
+        return std::numeric_limits<T>::lowest();
+      }
+      return static_cast<T>(std::trunc(v.f));
+    } else {
+      long double const max = std::numeric_limits<T>::max();
+      if (std::isinf(v.f)) {
+        return static_cast<T>(v.f);
+      } else if (v.f > max) {
+        return std::numeric_limits<T>::max();
+      } else if (v.f < -max) {
+        return std::numeric_limits<T>::lowest();
+      }
+      return static_cast<T>(v.f);
+    }
+  }
+
+  auto const clamped = [](auto n) {
+    if constexpr (std::is_integral_v<T>) {
+      if (compare_integers(n, std::numeric_limits<T>::max()) > 0) {
+        return std::numeric_limits<T>::max();
+      } else if (compare_integers(n, std::numeric_limits<T>::lowest()) < 0) {
+        return std::numeric_limits<T>::lowest();
+      }
+    }
+    return static_cast<T>(n); // always in range of floating-point types
+  };
+  return (v.kind == ScanOperand::Kind::Signed) ? clamped(v.i) : clamped(v.u);
+}
+
+// the next T above resp. below t, if any
+template <typename T> static std::optional<T> next_up(T t) {
+  if (t == highest_value<T>()) {
+    return std::nullopt;
+  } else if constexpr (std::is_integral_v<T>) {
+    return static_cast<T>(t + 1);
+  } else {
+    return std::nextafter(t, std::numeric_limits<T>::infinity());
+  }
+}
+
+template <typename T> static std::optional<T> next_down(T t) {
+  if (t == lowest_value<T>()) {
+    return std::nullopt;
+  } else if constexpr (std::is_integral_v<T>) {
+    return static_cast<T>(t - 1);
+  } else {
+    return std::nextafter(t, -std::numeric_limits<T>::infinity());
+  }
+}
+
+static bool is_nan(ScanOperand const& v) {
+  return v.kind == ScanOperand::Kind::Float && std::isnan(v.f);
+}
+
+// smallest resp. largest T >= v resp. <= v, if any
+template <typename T>
+static std::optional<T> ceil_value(ScanOperand const& v) {
+  if (is_nan(v)) {
+    return std::nullopt;
+  }
+  T const t = approximate<T>(v);
+  return (*compare(t, v) < 0) ? next_up(t) : t;
+}
+
+template <typename T>
+static std::optional<T> floor_value(ScanOperand const& v) {
+  if (is_nan(v)) {
+    return std::nullopt;
+  }
+  T const t = approximate<T>(v);
+  return (*compare(t, v) > 0) ? next_down(t) : t;
+}
+
+// v as T if it is representable exactly
+template <typename T>
+static std::optional<T> exact_value(ScanOperand const& v) {
+  auto const c = ceil_value<T>(v);
+  return (c && compare(*c, v) == 0) ? c : std::nullopt;
+}
+
+// smallest T > v resp. largest T < v, if any
+template <typename T>
+static std::optional<T> above_value(ScanOperand const& v) {
+  auto const c = ceil_value<T>(v);
+  return (c && compare(*c, v) == 0) ? next_up(*c) : c;
+}
+
+template <typename T>
+static std::optional<T> below_value(ScanOperand const& v) {
+  auto const f = floor_value<T>(v);
+  return (f && compare(*f, v) == 0) ? next_down(*f) : f;
+}
+
+namespace {
+// predicate resolved against the array: either lo <= value <= hi (negated if
+// negate is set) or membership in the sorted set values of type T
+struct condition {
+  enum class Kind { Range, In, None } kind;
+  size_t offset; // of the field within the records
+  size_t size;   // of the field
+  bool negate = false;
+  std::array<std::byte, 8> lo, hi;
+  std::vector<std::byte> values;
+
+  // clears the bits of the n rows in words that don't satisfy the condition;
+  // scratch has room for block_rows values of the field's type
+  void (*apply)(condition const&, std::byte const* rows, size_t stride,
+                size_t n, uint32_t* words, std::byte* scratch);
+};
+} // namespace
+
+static uint32_t tail_mask(size_t n) {
+  return (n % 32 == 0) ? ~uint32_t{0} : (uint32_t{1} << (n % 32)) - 1;
+}
+
+template <typename T>
+static uint32_t range_scalar(T const* x, size_t n, T lo, T hi) {
+  uint32_t bits = 0;
+  for (size_t i = 0; i < n; ++i) {
+    bits |= static_cast<uint32_t>(lo <= x[i] && x[i] <= hi) << i;
+  }
+  return bits;
+}
+
+template <typename T>
+static uint32_t in_scalar(T const* x, size_t n, T const* set,
+                          size_t set_size) {
+  // not std::binary_search(), which considers NaN equivalent to any value
+  uint32_t bits = 0;
+  for (size_t i = 0; i < n; ++i) {
+    T const* const it = std::lower_bound(set, set + set_size, x[i]);
+    bits |= static_cast<uint32_t>(it != set + set_size && *it == x[i]) << i;
+  }
+  return bits;
+}
+
+#ifdef CNPYPP_X86_SIMD
+template <typename T>
+__attribute__((target("avx2"))) static __m256i broadcast(T v) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm256_set1_epi8(static_cast<char>(v));
+  } else if constexpr (sizeof(T) == 2) {
+    return _mm256_set1_epi16(static_cast<short>(v));
+  } else if constexpr (sizeof(T) == 4) {
+    return _mm256_set1_epi32(static_cast<int>(v));
+  } else {
+    return _mm256_set1_epi64x(static_cast<long long>(v));
+  }
+}
+
+// signed comparison a > b per lane
+template <size_t N>
+__attribute__((target("avx2"))) static __m256i greater(__m256i a, __m256i b) {
+  if constexpr (N == 1) {
+    return _mm256_cmpgt_epi8(a, b);
+  } else if constexpr (N == 2) {
+    return _mm256_cmpgt_epi16(a, b);
+  } else if constexpr (N == 4) {
+    return _mm256_cmpgt_epi32(a, b);
+  } else {
+    return _mm256_cmpgt_epi64(a, b);
+  }
+}
+
+template <size_t N>
+__attribute__((target("avx2"))) static __m256i equal(__m256i a, __m256i b) {
+  if constexpr (N == 1) {
+    return _mm256_cmpeq_epi8(a, b);
+  } else if constexpr (N == 2) {
+    return _mm256_cmpeq_epi16(a, b);
+  } else if constexpr (N == 4) {
+    return _mm256_cmpeq_epi32(a, b);
+  } else {
+    return _mm256_cmpeq_epi64(a, b);
+  }
+}
+
+// one bit per lane of the all-ones/all-zeros lane masks m[0], m[1], ... that
+// cover 32 values of N bytes
+template <size_t N>
+__attribute__((target("avx2"))) static uint32_t lane_bits(__m256i const* m) {
+  if constexpr (N == 1) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(m[0]));
+  } else if constexpr (N == 2) {
+    // packs interleaves the 128-bit halves, permute restores the order
+    __m256i const packed = _mm256_permute4x64_epi64(
+        _mm256_packs_epi16(m[0], m[1]), _MM_SHUFFLE(3, 1, 2, 0));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(packed));
+  } else if constexpr (N == 4) {
+    uint32_t bits = 0;
+    for (int k = 0; k < 4; ++k) {
+      bits |= static_cast<uint32_t>(
+                  _mm256_movemask_ps(_mm256_castsi256_ps(m[k])))
+              << (8 * k);
+    }
+    return bits;
+  } else {
+    uint32_t bits = 0;
+    for (int k = 0; k < 8; ++k) {
+      bits |= static_cast<uint32_t>(
+                  _mm256_movemask_pd(_mm256_castsi256_pd(m[k])))
+              << (4 * k);
+    }
+    return bits;
+  }
+}
+
+// bit i set if lo <= x[i] <= hi, for 32 values
+template <typename T>
+__attribute__((target("avx2"))) static uint32_t range_avx2(T const* x, T lo,
+                                                           T hi) {
+  size_t constexpr lanes = 32 / sizeof(T);
+  __m256i m[32 / lanes];
+
+  if constexpr (std::is_same_v<T, float>) {
+    __m256 const l = _mm256_set1_ps(lo), h = _mm256_set1_ps(hi);
+    for (size_t k = 0; k < 32 / lanes; ++k) {
+      __m256 const v = _mm256_loadu_ps(x + k * lanes);
+      m[k] = _mm256_castps_si256(_mm256_and_ps(
+          _mm256_cmp_ps(l, v, _CMP_LE_OQ), _mm256_cmp_ps(v, h, _CMP_LE_OQ)));
+    }
+  } else if constexpr (std::is_same_v<T, double>) {
+    __m256d const l = _mm256_set1_pd(lo), h = _mm256_set1_pd(hi);
+    for (size_t k = 0; k < 32 / lanes; ++k) {
+      __m256d const v = _mm256_loadu_pd(x + k * lanes);
+      m[k] = _mm256_castpd_si256(_mm256_and_pd(
+          _mm256_cmp_pd(l, v, _CMP_LE_OQ), _mm256_cmp_pd(v, h, _CMP_LE_OQ)));
+    }
+  } else {
+    // AVX2 only compares signed integers: flip the sign bit of unsigned ones
+    using S = std::make_signed_t<T>;
+    __m256i const flip = broadcast<S>(std::is_signed_v<T>
+                                          ? S{0}
+                                          : std::numeric_limits<S>::lowest());
+    __m256i const l = _mm256_xor_si256(broadcast(lo), flip);
+    __m256i const h = _mm256_xor_si256(broadcast(hi), flip);
+
+    for (size_t k = 0; k < 32 / lanes; ++k) {
+      __m256i const v = _mm256_xor_si256(
+          _mm256_loadu_si256(reinterpret_cast<__m256i const*>(x + k * lanes)),
+          flip);
+      // !(l > v) && !(v > h)
+      m[k] = _mm256_andnot_si256(
+          _mm256_or_si256(greater<sizeof(T)>(l, v), greater<sizeof(T)>(v, h)),
+          _mm256_set1_epi8(-1));
+    }
+  }
+
+  return lane_bits<sizeof(T)>(m);
+}
+
+// bit i set if x[i] equals any of the set_size values in set, for 32 values
+template <typename T>
+__attribute__((target("avx2"))) static uint32_t
+in_avx2(T const* x, T const* set, size_t set_size) {
+  size_t constexpr lanes = 32 / sizeof(T);
+  __m256i m[32 / lanes];
+
+  for (size_t k = 0; k < 32 / lanes; ++k) {
+    __m256i acc = _mm256_setzero_si256();
+
+    if constexpr (std::is_same_v<T, float>) {
+      __m256 const v = _mm256_loadu_ps(x + k * lanes);
+      for (size_t j = 0; j < set_size; ++j) {
+        acc = _mm256_or_si256(acc, _mm256_castps_si256(_mm256_cmp_ps(
+                                       v, _mm256_set1_ps(set[j]), _CMP_EQ_OQ)));
+      }
+    } else if constexpr (std::is_same_v<T, double>) {
+      __m256d const v = _mm256_loadu_pd(x + k * lanes);
+      for (size_t j = 0; j < set_size; ++j) {
+        acc = _mm256_or_si256(acc, _mm256_castpd_si256(_mm256_cmp_pd(
+                                       v, _mm256_set1_pd(set[j]), _CMP_EQ_OQ)));
+      }
+    } else {
+      __m256i const v =
+          _mm256_loadu_si256(reinterpret_cast<__m256i const*>(x + k * lanes));
+      for (size_t j = 0; j < set_size; ++j) {
+        acc = _mm256_or_si256(acc, equal<sizeof(T)>(v, broadcast(set[j])));
+      }
+    }
+
+    m[k] = acc;
+  }
+
+  return lane_bits<sizeof(T)>(m);
+}
+#endif
+
+// sets beyond this size are searched for with binary search instead of
+// being compared with each value
+static size_t constexpr max_simd_set_size = 8;
+
+template <typename T>
+static void apply_condition(condition const& c, std::byte const* rows,
+                            size_t stride, size_t n, uint32_t* words,
+                            std::byte* scratch) {
+  // contiguous values of the field, gathered from the records if necessary
+  T const* x;
+  if (stride == sizeof(T)) {
+    x = reinterpret_cast<T const*>(rows + c.offset);
+  } else {
+    auto* const dst = reinterpret_cast<T*>(scratch);
+    for (size_t i = 0; i < n; ++i) {
+      std::memcpy(dst + i, rows + i * stride + c.offset, sizeof(T));
+    }
+    x = dst;
+  }
+
+  T lo, hi;
+  std::memcpy(&lo, c.lo.data(), sizeof(T));
+  std::memcpy(&hi, c.hi.data(), sizeof(T));
+  auto const* const set = reinterpret_cast<T const*>(c.values.data());
+  size_t const set_size = c.values.size() / sizeof(T);
+  uint32_t const flip = c.negate ? ~uint32_t{0} : 0;
+
+  size_t const num_words = (n + 31) / 32;
+  size_t w = 0;
+
+#ifdef CNPYPP_X86_SIMD
+  static bool const avx2 = __builtin_cpu_supports("avx2");
+  if (avx2 && (c.kind == condition::Kind::Range ||
+               set_size <= max_simd_set_size)) {
+    for (; w < n / 32; ++w) {
+      if (words[w] != 0) {
+        words[w] &= (c.kind == condition::Kind::Range)
+                        ? range_avx2(x + 32 * w, lo, hi) ^ flip
+                        : in_avx2(x + 32 * w, set, set_size);
+      }
+    }
+  }
+#endif
+
+  for (; w < num_words; ++w) {
+    size_t const count = std::min(size_t{32}, n - 32 * w);
+    if (words[w] != 0) {
+      words[w] &= ((c.kind == condition::Kind::Range)
+                       ? range_scalar(x + 32 * w, count, lo, hi) ^ flip
+                       : in_scalar(x + 32 * w, count, set, set_size)) &
+                  tail_mask(count);
+    }
+  }
+}
+
+template <typename T>
+static condition make_condition(ScanPredicate const& p, size_t offset) {
+  condition c;
+  c.offset = offset;
+  c.size = sizeof(T);
+  c.apply = &apply_condition<T>;
+
+  auto const& v = p.operands;
+  size_t const expected = (p.op == ScanPredicate::Op::Between) ? 2
+                          : (p.op == ScanPredicate::Op::In)    ? v.size()
+                                                               : 1;
+  if (v.size() != expected) {
+    throw std::runtime_error("scan: wrong number of operands for field \"" +
+                             p.field + "\"");
+  }
+
+  std::optional<T> lo = lowest_value<T>(), hi = highest_value<T>();
+
+  switch (p.op) {
+  case ScanPredicate::Op::Less:
+    hi = below_value<T>(v[0]);
+    break;
+  case ScanPredicate::Op::LessEqual:
+    hi = floor_value<T>(v[0]);
+    break;
+  case ScanPredicate::Op::Greater:
+    lo = above_value<T>(v[0]);
+    break;
+  case ScanPredicate::Op::GreaterEqual:
+    lo = ceil_value<T>(v[0]);
+    break;
+  case ScanPredicate::Op::Between:
+    lo = ceil_value<T>(v[0]);
+    hi = floor_value<T>(v[1]);
+    break;
+  case ScanPredicate::Op::Equal:
+  case ScanPredicate::Op::NotEqual:
+    // the operand only if it is representable as T
+    lo = ceil_value<T>(v[0]);
+    hi = floor_value<T>(v[0]);
+    c.negate = (p.op == ScanPredicate::Op::NotEqual);
+    break;
+  case ScanPredicate::Op::In: {
+    std::vector<T> set;
+    for (auto const& value : v) {
+      if (auto const t = exact_value<T>(value)) {
+        set.push_back(*t);
+      }
+    }
+    std::sort(set.begin(), set.end());
+    set.erase(std::unique(set.begin(), set.end()), set.end());
+
+    c.kind = set.empty() ? condition::Kind::None : condition::Kind::In;
+    c.values.resize(set.size() * sizeof(T));
+    std::memcpy(c.values.data(), set.data(), c.values.size());
+    return c;
+  }
+  }
+
+  if (!lo || !hi || *lo > *hi) {
+    if (c.negate) {
+      // "not equal" to a value not representable as T, always true: the
+      // negation of an empty range, which also holds for NaN values
+      lo = highest_value<T>();
+      hi = lowest_value<T>();
+      c.kind = condition::Kind::Range;
+    } else {
+      c.kind = condition::Kind::None;
+      return c;
+    }
+  } else {
+    c.kind = condition::Kind::Range;
+  }
+
+  std::memcpy(c.lo.data(), &*lo, sizeof(T));
+  std::memcpy(c.hi.data(), &*hi, sizeof(T));
+  return c;
+}
+
+static std::vector<condition>
+make_conditions(NpyArray const& array,
+                std::vector<ScanPredicate> const& predicates) {
+  std::vector<condition> conditions;
+
+  for (auto const& p : predicates) {
+    size_t i = 0, offset = 0;
+
+    if (array.labels.empty()) {
+      if (!p.field.empty()) {
+        throw std::runtime_error("scan: array has no field \"" + p.field +
+                                 "\"");
+      }
+    } else {
+      auto const it =
+          std::find(array.labels.cbegin(), array.labels.cend(), p.field);
+      if (p.field.empty() || it == array.labels.cend()) {
+        throw std::runtime_error("scan: array has no field \"" + p.field +
+                                 "\"");
+      }
+      i = std::distance(array.labels.cbegin(), it);
+      offset = std::accumulate(array.word_sizes.cbegin(),
+                               array.word_sizes.cbegin() + i, size_t{0});
+      if (!array.field_shapes[i].empty()) {
+        throw std::runtime_error("scan: sub-array field \"" + p.field +
+                                 "\" not supported");
+      }
+    }
+
+    char const type = array.data_types[i];
+    size_t const size = array.word_sizes[i];
+
+    if ((type == 'i' || type == 'u' || type == 'b') && size == 1) {
+      conditions.push_back((type == 'i') ? make_condition<int8_t>(p, offset)
+                                         : make_condition<uint8_t>(p, offset));
+    } else if (type == 'i' && size == 2) {
+      conditions.push_back(make_condition<int16_t>(p, offset));
+    } else if (type == 'u' && size == 2) {
+      conditions.push_back(make_condition<uint16_t>(p, offset));
+    } else if (type == 'i' && size == 4) {
+      conditions.push_back(make_condition<int32_t>(p, offset));
+    } else if (type == 'u' && size == 4) {
+      conditions.push_back(make_condition<uint32_t>(p, offset));
+    } else if (type == 'i' && size == 8) {
+      conditions.push_back(make_condition<int64_t>(p, offset));
+    } else if (type == 'u' && size == 8) {
+      conditions.push_back(make_condition<uint64_t>(p, offset));
+    } else if (type == 'f' && size == 4) {
+      conditions.push_back(make_condition<float>(p, offset));
+    } else if (type == 'f' && size == 8) {
+      conditions.push_back(make_condition<double>(p, offset));
+    } else {
+      throw std::runtime_error("scan: type of field \"" + p.field +
+                               "\" not supported");
+    }
+  }
+
+  return conditions;
+}
+
+// calls f(block) for all blocks of rows, distributed dynamically among
+// num_threads threads
+template <typename F>
+static void for_each_block(size_t num_blocks, unsigned num_threads,
+                           F const& f) {
+  std::atomic<size_t> next_block{0};
+
+  auto const worker = [&]() {
+    size_t block;
+    while ((block = next_block.fetch_add(1, std::memory_order_relaxed)) <
+           num_blocks) {
+      f(block);
+    }
+  };
+
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = static_cast<unsigned>(
+      std::max<size_t>(1, std::min<size_t>(num_threads, num_blocks)));
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (unsigned t = 1; t < num_threads; ++t) {
+    threads.emplace_back(worker);
+  }
+  worker();
+
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+// writes the selection bitmap (BitOrder::Little) to bits and returns the
+// number of selected rows per block
+static std::vector<size_t>
+evaluate(NpyArray const& array, std::vector<ScanPredicate> const& predicates,
+         uint8_t* bits, unsigned num_threads) {
+  auto const conditions = make_conditions(array, predicates);
+  size_t const num_rows = array.num_vals;
+  size_t const stride = array.total_value_size;
+  size_t const num_blocks = (num_rows + block_rows - 1) / block_rows;
+  size_t const max_size = std::accumulate(
+      conditions.cbegin(), conditions.cend(), size_t{1},
+      [](size_t m, condition const& c) { return std::max(m, c.size); });
+
+  std::vector<size_t> counts(num_blocks);
+  std::byte const* const data = array.data<std::byte>();
+
+  for_each_block(num_blocks, num_threads, [&](size_t block) {
+    thread_local std::vector<std::byte> scratch;
+    scratch.resize(block_rows * max_size);
+
+    size_t const first = block * block_rows;
+    size_t const n = std::min(block_rows, num_rows - first);
+    size_t const num_words = (n + 31) / 32;
+
+    std::array<uint32_t, block_words> words;
+    std::fill_n(words.begin(), num_words, ~uint32_t{0});
+    words[num_words - 1] = tail_mask(n);
+
+    for (auto const& c : conditions) {
+      if (c.kind == condition::Kind::None) {
+        std::fill_n(words.begin(), num_words, 0);
+        break;
+      }
+      c.apply(c, data + first * stride, stride, n, words.data(),
+              scratch.data());
+    }
+
+    uint8_t* const dst = bits + first / 8;
+    for (size_t w = 0; w < num_words; ++w) {
+      // partial last word: only the bytes holding rows
+      uint8_t word_bytes[4];
+      boost::endian::endian_store<uint32_t, 4, boost::endian::order::little>(
+          word_bytes, words[w]);
+      size_t const num_bytes = std::min(size_t{4}, (n - 32 * w + 7) / 8);
+      std::copy_n(word_bytes, num_bytes, dst + 4 * w);
+    }
+    counts[block] = count_bits(dst, n, BitOrder::Little);
+  });
+
+  return counts;
+}
+
+// calls f(first, n) for the runs of n consecutive selected rows starting at
+// first within the block
+template <typename F>
+static void for_each_run(uint8_t const* bits, size_t block, size_t num_rows,
+                         F const& f) {
+  size_t const first = block * block_rows;
+  size_t const end = std::min(first + block_rows, num_rows);
+  size_t run_first = 0, run_size = 0;
+
+  for (size_t i = first; i < end; ++i) {
+    if (detail::test_bit(bits, i, BitOrder::Little)) {
+      if (run_size > 0 && run_first + run_size == i) {
+        ++run_size;
+      } else {
+        if (run_size > 0) {
+          f(run_first, run_size);
+        }
+        run_first = i;
+        run_size = 1;
+      }
+    }
+  }
+
+  if (run_size > 0) {
+    f(run_first, run_size);
+  }
+}
+
+PackedBitArray cnpypp::scan(NpyArray const& array,
+                            std::vector<ScanPredicate> const& predicates,
+                            unsigned num_threads) {
+  size_t const num_bytes = (array.num_vals + 7) / 8;
+  auto buffer = std::make_unique<InMemoryBuffer>(num_bytes);
+
+  evaluate(array, predicates, reinterpret_cast<uint8_t*>(buffer->data()),
+           num_threads);
+
+  return PackedBitArray{NpyArray{{num_bytes},
+                                 {1},
+                                 {'u'},
+                                 {},
+                                 {},
+                                 MemoryOrder::C,
+                                 std::move(buffer)},
+                        array.num_vals, BitOrder::Little};
+}
+
+std::vector<size_t>
+cnpypp::scan_indices(NpyArray const& array,
+                     std::vector<ScanPredicate> const& predicates,
+                     unsigned num_threads) {
+  std::vector<uint8_t> bits((array.num_vals + 7) / 8);
+  auto counts = evaluate(array, predicates, bits.data(), num_threads);
+
+  // position of each block's first index in the result
+  size_t const total = std::accumulate(counts.begin(), counts.end(), size_t{0});
+  std::exclusive_scan(counts.begin(), counts.end(), counts.begin(), size_t{0});
+
+  std::vector<size_t> indices(total);
+  for_each_block(counts.size(), num_threads, [&](size_t block) {
+    size_t* dst = indices.data() + counts[block];
+    for_each_run(bits.data(), block, array.num_vals,
+                 [&dst](size_t first, size_t n) {
+                   std::iota(dst, dst + n, first);
+                   dst += n;
+                 });
+  });
+
+  return indices;
+}
+
+NpyArray cnpypp::scan_select(NpyArray const& array,
+                             std::vector<ScanPredicate> const& predicates,
+                             unsigned num_threads) {
+  std::vector<uint8_t> bits((array.num_vals + 7) / 8);
+  auto counts = evaluate(array, predicates, bits.data(), num_threads);
+
+  size_t const total = std::accumulate(counts.begin(), counts.end(), size_t{0});
+  std::exclusive_scan(counts.begin(), counts.end(), counts.begin(), size_t{0});
+
+  size_t const record_size = array.total_value_size;
+  auto buffer = std::make_unique<InMemoryBuffer>(total * record_size);
+  std::byte const* const src = array.data<std::byte>();
+
+  for_each_block(counts.size(), num_threads, [&](size_t block) {
+    std::byte* dst = buffer->data() + counts[block] * record_size;
+    for_each_run(bits.data(), block, array.num_vals,
+                 [&dst, src, record_size](size_t first, size_t n) {
+                   std::memcpy(dst, src + first * record_size,
+                               n * record_size);
+                   dst += n * record_size;
+                 });
+  });
+
+  return NpyArray{{total},           array.word_sizes,
+                  array.data_types,  array.labels,
+                  array.field_shapes, MemoryOrder::C,
+                  std::move(buffer)};
+}
@@ -0,0 +1,133 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#include <cerrno>
+#include <cstddef>
+#include <numeric>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+// shm_open() and mmap() are only available on POSIX systems
+#ifdef CNPYPP_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// shm_open() requires names of the form "/name"
+static std::string shm_name(std::string const& name) {
+  return (!name.empty() && name.front() == '/') ? name : '/' + name;
+}
+
+cnpypp::NpyArray cnpypp::npy_create_shm(std::string const& name,
+                                        cnpypp::span<size_t const> shape,
+                                        char data_type, size_t word_size,
+                                        MemoryOrder memory_order) {
+  std::vector<char> const header =
+      create_npy_header(shape, data_type, word_size, memory_order);
+  size_t const num_bytes = std::accumulate(
+      shape.begin(), shape.end(), word_size, std::multiplies<size_t>());
+
+  // An existing object is unlinked rather than truncated: consumers that
+  // still have it mapped keep the old data instead of faulting on pages cut
+  // off or seeing them overwritten. If another process recreates the name
+  // in between, that object is replaced as well.
+  std::string const path = shm_name(name);
+  int fd;
+
+  do {
+    if (::shm_unlink(path.c_str()) != 0 && errno != ENOENT) {
+      throw std::system_error{errno, std::generic_category(),
+                              "npy_create_shm: could not replace " + name};
+    }
+    fd = ::shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  } while (fd < 0 && errno == EEXIST);
+
+  if (fd < 0) {
+    throw std::system_error{errno, std::generic_category(),
+                            "npy_create_shm: could not create " + name};
+  }
+
+  try {
+    if (::ftruncate(fd, static_cast<off_t>(header.size() + num_bytes)) != 0) {
+      throw std::system_error{errno, std::generic_category(),
+                              "npy_create_shm: could not resize " + name};
+    } else if (::pwrite(fd, header.data(), header.size(), 0) !=
+               static_cast<ssize_t>(header.size())) {
+      throw std::system_error{errno, std::generic_category(),
+                              "npy_create_shm: could not write header"};
+    }
+
+    auto buffer = std::make_unique<WritableMemoryMappedBuffer>(
+        fd, header.size(), num_bytes);
+    ::close(fd);
+
+    return cnpypp::NpyArray{std::vector<size_t>(shape.begin(), shape.end()),
+                            {word_size},
+                            {data_type},
+                            {},
+                            {},
+                            memory_order,
+                            std::move(buffer)};
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+}
+
+cnpypp::NpyArray cnpypp::npy_load_shm(std::string const& name) {
+  int const fd = ::shm_open(shm_name(name).c_str(), O_RDONLY, 0);
+
+  if (fd < 0) {
+    throw std::system_error{errno, std::generic_category(),
+                            "npy_load_shm: could not open " + name};
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    int const error = errno;
+    ::close(fd);
+    throw std::system_error{error, std::generic_category(),
+                            "npy_load_shm: fstat() failed"};
+  }
+
+  size_t const size = st.st_size;
+
+  if (size == 0) {
+    ::close(fd);
+    throw std::runtime_error("npy_load_shm: " + name + " is empty");
+  }
+
+  void* const mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  int const error = errno;
+  ::close(fd);
+
+  if (mapping == MAP_FAILED) {
+    throw std::system_error{error, std::generic_category(),
+                            "npy_load_shm: mmap() failed"};
+  }
+
+  try {
+    // the header is validated against the size of the object
+    return npy_load_from(
+        cnpypp::span<std::byte const>{static_cast<std::byte const*>(mapping),
+                                      size},
+        [mapping, size]() { ::munmap(mapping, size); });
+  } catch (...) {
+    ::munmap(mapping, size);
+    throw;
+  }
+}
+
+void cnpypp::npy_remove_shm(std::string const& name) {
+  if (::shm_unlink(shm_name(name).c_str()) != 0) {
+    throw std::system_error{errno, std::generic_category(),
+                            "npy_remove_shm: could not remove " + name};
+  }
+}
+#endif
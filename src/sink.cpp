@@ -0,0 +1,128 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#include <cerrno>
+#include <cstddef>
+#include <system_error>
+#include <utility>
+
+#include <cnpy++/sink.hpp>
+
+#ifdef CNPYPP_POSIX
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+void cnpypp::Sink::write(std::byte const* header, size_t header_size,
+                         std::byte const* payload, size_t payload_size) {
+  write(header, header_size);
+  write(payload, payload_size);
+}
+
+#ifdef CNPYPP_POSIX
+cnpypp::FileDescriptorSink::FileDescriptorSink(int fd_)
+    : fd{fd_}, owning{false} {}
+
+cnpypp::FileDescriptorSink::FileDescriptorSink(std::string const& fname)
+    : fd{::open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                0666)},
+      owning{true} {
+  if (fd < 0) {
+    throw std::system_error{errno, std::generic_category(),
+                            "FileDescriptorSink: could not open " + fname};
+  }
+}
+
+cnpypp::FileDescriptorSink::~FileDescriptorSink() {
+  if (owning) {
+    ::close(fd);
+  }
+}
+
+void cnpypp::FileDescriptorSink::write(std::byte const* data, size_t size) {
+  while (size > 0) {
+    ssize_t const n = ::write(fd, data, size);
+
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error{errno, std::generic_category(),
+                              "FileDescriptorSink: write() failed"};
+    } else if (n == 0) {
+      throw std::system_error{EIO, std::generic_category(),
+                              "FileDescriptorSink: write() wrote nothing"};
+    }
+
+    data += n;
+    size -= n;
+  }
+}
+
+void cnpypp::FileDescriptorSink::write(std::byte const* header,
+                                       size_t header_size,
+                                       std::byte const* payload,
+                                       size_t payload_size) {
+  iovec iov[2] = {{const_cast<std::byte*>(header), header_size},
+                  {const_cast<std::byte*>(payload), payload_size}};
+  iovec* first = iov;
+  int count = 2;
+
+  // writev() may write less than requested (signals, large sizes), in which
+  // case the remainder is resubmitted
+  while (true) {
+    while (count > 0 && first->iov_len == 0) {
+      ++first;
+      --count;
+    }
+    if (count == 0) {
+      break;
+    }
+
+    ssize_t n = ::writev(fd, first, count);
+
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error{errno, std::generic_category(),
+                              "FileDescriptorSink: writev() failed"};
+    } else if (n == 0) {
+      throw std::system_error{EIO, std::generic_category(),
+                              "FileDescriptorSink: writev() wrote nothing"};
+    }
+
+    while (count > 0 && static_cast<size_t>(n) >= first->iov_len) {
+      n -= first->iov_len;
+      ++first;
+      --count;
+    }
+
+    if (count > 0) {
+      first->iov_base = static_cast<char*>(first->iov_base) + n;
+      first->iov_len -= n;
+    }
+  }
+}
+#endif
+
+cnpypp::MemorySink::MemorySink(std::vector<std::byte>& target_)
+    : target{target_} {}
+
+void cnpypp::MemorySink::reserve(size_t size) {
+  target.reserve(target.size() + size);
+}
+
+void cnpypp::MemorySink::write(std::byte const* data, size_t size) {
+  target.insert(target.end(), data, data + size);
+}
+
+cnpypp::CallbackSink::CallbackSink(callback_type callback_)
+    : callback{std::move(callback_)} {}
+
+void cnpypp::CallbackSink::write(std::byte const* data, size_t size) {
+  callback(data, size);
+}
@@ -0,0 +1,495 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#ifndef NO_LIBZIP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/endian/conversion.hpp>
+
+#include "cnpy++.hpp"
+
+using namespace cnpypp;
+
+template <typename T> static T load_le(char const* ptr) {
+  return boost::endian::endian_load<T, sizeof(T),
+                                    boost::endian::order::little>(
+      reinterpret_cast<unsigned char const*>(ptr));
+}
+
+// Offsets of the data of the uncompressed entries of the zip file fname,
+// taken from the central directory and the local headers, as libzip does not
+// expose them. Handles zip64 archives as written by numpy.savez().
+static std::map<std::string, size_t, std::less<>>
+stored_entry_offsets(std::string const& fname) {
+  std::ifstream fs{fname, std::ios::binary | std::ios::ate};
+  size_t const file_size = fs.tellg();
+
+  // end of central directory record: 22 bytes + comment of up to 64 KiB
+  size_t const tail_size = std::min(file_size, size_t{22 + 0xffff});
+  std::vector<char> tail(tail_size);
+  fs.seekg(file_size - tail_size);
+  fs.read(tail.data(), tail_size);
+
+  if (!fs || tail_size < 22) {
+    throw std::runtime_error("load_sparse_npz: could not read zip directory");
+  }
+
+  size_t eocd = tail_size - 22;
+  while (load_le<uint32_t>(&tail[eocd]) != 0x06054b50) {
+    if (eocd == 0) {
+      throw std::runtime_error(
+          "load_sparse_npz: end of central directory not found");
+    }
+    --eocd;
+  }
+
+  uint64_t num_entries = load_le<uint16_t>(&tail[eocd + 10]);
+  uint64_t directory_offset = load_le<uint32_t>(&tail[eocd + 16]);
+
+  if (directory_offset == 0xffffffff && eocd >= 20 &&
+      load_le<uint32_t>(&tail[eocd - 20]) == 0x07064b50) {
+    // zip64 end of central directory record
+    std::array<char, 56> record;
+    fs.seekg(load_le<uint64_t>(&tail[eocd - 12]));
+    fs.read(record.data(), record.size());
+
+    if (!fs || load_le<uint32_t>(record.data()) != 0x06064b50) {
+      throw std::runtime_error(
+          "load_sparse_npz: malformed zip64 end of central directory");
+    }
+
+    num_entries = load_le<uint64_t>(&record[32]);
+    directory_offset = load_le<uint64_t>(&record[48]);
+  }
+
+  std::map<std::string, size_t, std::less<>> offsets;
+  fs.seekg(directory_offset);
+
+  for (uint64_t i = 0; i < num_entries; ++i) {
+    std::array<char, 46> entry;
+    fs.read(entry.data(), entry.size());
+
+    if (!fs || load_le<uint32_t>(entry.data()) != 0x02014b50) {
+      throw std::runtime_error("load_sparse_npz: malformed central directory");
+    }
+
+    uint16_t const method = load_le<uint16_t>(&entry[10]);
+    uint32_t const compressed_size = load_le<uint32_t>(&entry[20]);
+    uint32_t const uncompressed_size = load_le<uint32_t>(&entry[24]);
+    uint16_t const name_length = load_le<uint16_t>(&entry[28]);
+    uint16_t const extra_length = load_le<uint16_t>(&entry[30]);
+    uint16_t const comment_length = load_le<uint16_t>(&entry[32]);
+    uint64_t local_offset = load_le<uint32_t>(&entry[42]);
+
+    std::vector<char> name_extra(name_length + extra_length);
+    fs.read(name_extra.data(), name_extra.size());
+    fs.seekg(comment_length, std::ios::cur);
+
+    if (local_offset == 0xffffffff) {
+      // zip64 extended information: the 64-bit values of the fields set to
+      // 0xffffffff, in the order uncompressed size, compressed size, offset
+      for (size_t pos = name_length; pos + 4 <= name_extra.size();) {
+        uint16_t const id = load_le<uint16_t>(&name_extra[pos]);
+        uint16_t const size = load_le<uint16_t>(&name_extra[pos + 2]);
+
+        if (id == 0x0001) {
+          size_t field = pos + 4 + 8 * ((uncompressed_size == 0xffffffff) +
+                                        (compressed_size == 0xffffffff));
+          local_offset = load_le<uint64_t>(&name_extra[field]);
+          break;
+        }
+        pos += 4 + size;
+      }
+    }
+
+    if (method == 0) {
+      offsets.emplace(std::string{name_extra.data(), name_length},
+                      local_offset);
+    }
+  }
+
+  // the data follow the local header, whose extra field may differ from the
+  // one in the central directory
+  for (auto& [name, offset] : offsets) {
+    std::array<char, 30> header;
+    fs.seekg(offset);
+    fs.read(header.data(), header.size());
+
+    if (!fs || load_le<uint32_t>(header.data()) != 0x04034b50) {
+      throw std::runtime_error("load_sparse_npz: malformed local header");
+    }
+
+    offset += header.size() + load_le<uint16_t>(&header[26]) +
+              load_le<uint16_t>(&header[28]);
+  }
+
+  return offsets;
+}
+
+using parameters_list =
+    std::vector<std::unique_ptr<detail::additional_parameters>>;
+
+namespace {
+// NPY file in an npz archive, opened for reading and positioned after the
+// header
+struct npz_entry {
+  zip_file_t* file = nullptr;
+  bool stored;
+  size_t header_size;
+  std::vector<size_t> shape, word_sizes;
+  std::vector<char> data_types;
+  std::vector<std::string> labels;
+  std::vector<std::vector<size_t>> field_shapes;
+  MemoryOrder memory_order;
+
+  npz_entry() = default;
+  npz_entry(npz_entry const&) = delete;
+  ~npz_entry() {
+    if (file) {
+      zip_fclose(file);
+    }
+  }
+
+  size_t num_vals() const {
+    return std::accumulate(shape.begin(), shape.end(), size_t{1},
+                           std::multiplies<size_t>());
+  }
+
+  size_t num_bytes() const {
+    return num_vals() * std::accumulate(word_sizes.begin(), word_sizes.end(),
+                                        size_t{0});
+  }
+
+  void read(void* dst, size_t size) {
+    if (zip_fread(file, dst, size) != static_cast<zip_int64_t>(size)) {
+      throw std::runtime_error{"load_sparse_npz: zip_fread() failed"};
+    }
+  }
+
+  void open(zip_t* archive, std::string_view name) {
+    std::string const filename = std::string{name} + ".npy";
+    zip_int64_t const index =
+        zip_name_locate(archive, filename.c_str(), ZIP_FL_ENC_RAW);
+    zip_stat_t fileinfo;
+
+    if (index == -1 ||
+        zip_stat_index(archive, index, ZIP_FL_ENC_RAW, &fileinfo) != 0) {
+      throw std::runtime_error("load_sparse_npz: entry \"" + filename +
+                               "\" not found");
+    }
+
+    stored = (fileinfo.valid & ZIP_STAT_COMP_METHOD) &&
+             fileinfo.comp_method == ZIP_CM_STORE;
+    file = zip_fopen_index(archive, index, ZIP_FL_ENC_RAW);
+
+    if (!file) {
+      throw std::runtime_error{"load_sparse_npz: zip_fopen_index() failed"};
+    }
+
+    // preamble with the header length, then the header itself
+    std::vector<char> header(10);
+    read(header.data(), header.size());
+    header.resize(10 + load_le<uint16_t>(&header[8]));
+    read(header.data() + 10, header.size() - 10);
+
+    header_size = parse_npy_header(header, word_sizes, data_types, labels,
+                                   field_shapes, shape, memory_order);
+  }
+};
+} // namespace
+
+static std::string read_format(npz_entry& entry) {
+  if (!entry.labels.empty() || entry.num_vals() != 1 ||
+      (entry.data_types[0] != 'S' && entry.data_types[0] != 'U')) {
+    throw std::runtime_error("load_sparse_npz: malformed \"format\" entry");
+  }
+
+  std::vector<char> chars(entry.num_bytes());
+  entry.read(chars.data(), chars.size());
+
+  std::string format;
+  // 'U' is UCS-4, the format names are ASCII
+  size_t const stride = (entry.data_types[0] == 'U') ? 4 : 1;
+  for (size_t i = 0; i < chars.size() && chars[i] != '\0'; i += stride) {
+    format.push_back(chars[i]);
+  }
+
+  return format;
+}
+
+static std::array<size_t, 2> read_shape(npz_entry& entry) {
+  if (!entry.labels.empty() || entry.num_vals() != 2 ||
+      entry.data_types[0] != 'i' ||
+      (entry.word_sizes[0] != 4 && entry.word_sizes[0] != 8)) {
+    throw std::runtime_error("load_sparse_npz: malformed \"shape\" entry");
+  }
+
+  std::array<char, 16> values;
+  entry.read(values.data(), entry.num_bytes());
+
+  if (entry.word_sizes[0] == 4) {
+    return {static_cast<size_t>(load_le<int32_t>(&values[0])),
+            static_cast<size_t>(load_le<int32_t>(&values[4]))};
+  } else {
+    return {static_cast<size_t>(load_le<int64_t>(&values[0])),
+            static_cast<size_t>(load_le<int64_t>(&values[8]))};
+  }
+}
+
+static bool is_index_array(npz_entry const& entry) {
+  return entry.labels.empty() && entry.shape.size() == 1 &&
+         entry.data_types[0] == 'i' &&
+         (entry.word_sizes[0] == 4 || entry.word_sizes[0] == 8);
+}
+
+SparseMatrix cnpypp::load_sparse_npz(std::string const& fname,
+                                     bool memory_mapped) {
+  int errcode = 0;
+  zip_t* const archive = zip_open(fname.c_str(), ZIP_RDONLY, &errcode);
+  if (!archive) {
+    zip_error_t err;
+    zip_error_init_with_code(&err, errcode);
+    throw std::runtime_error(zip_error_strerror(&err));
+  }
+
+  // declared before the entries so that these are closed first
+  std::unique_ptr<zip_t, int (*)(zip_t*)> const archive_guard{archive,
+                                                              &zip_close};
+
+  std::array<std::string_view, 3> const names = {"data", "indices",
+                                                 "indptr"};
+  npz_entry format_entry, shape_entry;
+  std::array<npz_entry, 3> entries;
+
+  format_entry.open(archive, "format");
+  shape_entry.open(archive, "shape");
+  for (size_t i = 0; i < entries.size(); ++i) {
+    entries[i].open(archive, names[i]);
+  }
+
+  std::string const format_name = read_format(format_entry);
+  if (format_name != "csr" && format_name != "csc") {
+    throw std::runtime_error("load_sparse_npz: format \"" + format_name +
+                             "\" not supported (only csr and csc)");
+  }
+
+  SparseFormat const format =
+      (format_name == "csr") ? SparseFormat::CSR : SparseFormat::CSC;
+  std::array<size_t, 2> const shape = read_shape(shape_entry);
+  size_t const major = (format == SparseFormat::CSR) ? shape[0] : shape[1];
+
+  auto const& [data, indices, indptr] = entries;
+
+  if (!data.labels.empty() || data.shape.size() != 1) {
+    throw std::runtime_error(
+        "load_sparse_npz: \"data\" is not a one-dimensional array");
+  } else if (!is_index_array(indices) || !is_index_array(indptr)) {
+    throw std::runtime_error("load_sparse_npz: \"indices\" and \"indptr\" "
+                             "have to be int32 or int64 arrays");
+  } else if (indices.num_vals() != data.num_vals() ||
+             indptr.num_vals() != major + 1) {
+    throw std::runtime_error(
+        "load_sparse_npz: array sizes do not match the shape");
+  }
+
+  std::shared_ptr<Buffer> storage;
+  std::array<size_t, 3> offsets;
+
+  bool const map = memory_mapped &&
+                   std::all_of(entries.begin(), entries.end(),
+                               [](auto const& e) { return e.stored; });
+
+  if (map) {
+    auto const entry_offsets = stored_entry_offsets(fname);
+    for (size_t i = 0; i < entries.size(); ++i) {
+      auto const it = entry_offsets.find(std::string{names[i]} + ".npy");
+      if (it == entry_offsets.end()) {
+        throw std::runtime_error(
+            "load_sparse_npz: entry not found in zip directory");
+      }
+      offsets[i] = it->second + entries[i].header_size;
+    }
+
+    // one mapping covering all three arrays
+    size_t begin = offsets[0], end = offsets[0];
+    for (size_t i = 0; i < entries.size(); ++i) {
+      begin = std::min(begin, offsets[i]);
+      end = std::max(end, offsets[i] + entries[i].num_bytes());
+    }
+
+    storage = std::make_shared<MemoryMappedBuffer>(fname, begin, end - begin);
+    for (auto& offset : offsets) {
+      offset -= begin;
+    }
+  } else {
+    // one allocation, each array aligned to a cache line
+    size_t total = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+      offsets[i] = total;
+      total += (entries[i].num_bytes() + 63) / 64 * 64;
+    }
+
+    storage = std::make_shared<InMemoryBuffer>(total);
+    for (size_t i = 0; i < entries.size(); ++i) {
+      entries[i].read(storage->data() + offsets[i], entries[i].num_bytes());
+    }
+  }
+
+  auto const view = [&storage, &offsets, &entries](size_t i) {
+    auto& entry = entries[i];
+    return NpyArray{std::move(entry.shape),
+                    std::move(entry.word_sizes),
+                    std::move(entry.data_types),
+                    {},
+                    {},
+                    entry.memory_order,
+                    std::make_unique<ExternalBuffer>(
+                        storage->data() + offsets[i], [storage] {})};
+  };
+
+  return SparseMatrix{format, shape, view(0), view(1), view(2)};
+}
+
+// adds an NPY entry with the given header and data to the archive; the data
+// are read when the archive is closed
+static void add_entry(zip_t* archive, std::string const& name,
+                      std::vector<char>&& header, void const* data,
+                      size_t num_bytes, bool compressed,
+                      parameters_list& parameters) {
+  auto const* src = static_cast<char const*>(data);
+  auto callback = [src, remaining = num_bytes](
+                      cnpypp::span<char> libzip_buffer,
+                      detail::additional_parameters*) mutable -> size_t {
+    size_t const n = std::min(libzip_buffer.size(), remaining);
+    std::copy_n(src, n, libzip_buffer.data());
+    src += n;
+    remaining -= n;
+    return n;
+  };
+
+  auto& params =
+      parameters.emplace_back(std::make_unique<detail::additional_parameters>(
+          std::move(header), 1, callback));
+
+  zip_source_t* const source =
+      zip_source_function(archive, detail::npzwrite_source_callback,
+                          reinterpret_cast<void*>(params.get()));
+  zip_int64_t const index =
+      zip_file_add(archive, (name + ".npy").c_str(), source,
+                   ZIP_FL_OVERWRITE | ZIP_FL_ENC_UTF_8);
+
+  if (index == -1) {
+    zip_source_free(source);
+    throw std::runtime_error(zip_strerror(archive));
+  }
+
+  if (!compressed) {
+    zip_set_file_compression(archive, index, ZIP_CM_STORE, 0);
+  }
+}
+
+void cnpypp::detail::save_sparse_npz(std::string const& fname,
+                                     SparseFormat format,
+                                     std::array<size_t, 2> shape,
+                                     sparse_component data,
+                                     sparse_component indices,
+                                     sparse_component indptr,
+                                     bool compressed) {
+  size_t const major = (format == SparseFormat::CSR) ? shape[0] : shape[1];
+
+  if (indices.data_type != 'i' || indptr.data_type != 'i' ||
+      (indices.word_size != 4 && indices.word_size != 8) ||
+      indices.word_size != indptr.word_size) {
+    throw std::runtime_error("save_sparse_npz: \"indices\" and \"indptr\" "
+                             "have to be both int32 or int64");
+  } else if (indices.num_vals != data.num_vals ||
+             indptr.num_vals != major + 1) {
+    throw std::runtime_error(
+        "save_sparse_npz: array sizes do not match the shape");
+  }
+
+  int errcode = 0;
+  zip_t* const archive =
+      zip_open(fname.c_str(), ZIP_CREATE | ZIP_TRUNCATE, &errcode);
+  if (!archive) {
+    zip_error_t err;
+    zip_error_init_with_code(&err, errcode);
+    throw std::runtime_error(zip_error_strerror(&err));
+  }
+
+  // have to stay alive until zip_close()
+  parameters_list parameters;
+  std::array<char, 3> const format_name = (format == SparseFormat::CSR)
+                                              ? std::array{'c', 's', 'r'}
+                                              : std::array{'c', 's', 'c'};
+  std::array<int64_t, 2> const shape_values = {
+      static_cast<int64_t>(shape[0]), static_cast<int64_t>(shape[1])};
+
+  auto const header = [](size_t num_vals, sparse_component const& c) {
+    size_t const array_shape[] = {num_vals};
+    return create_npy_header(array_shape, c.data_type, c.word_size);
+  };
+
+  try {
+    // same entries in the same order as scipy.sparse.save_npz()
+    add_entry(archive, "indices", header(indices.num_vals, indices),
+              indices.data, indices.num_vals * indices.word_size, compressed,
+              parameters);
+    add_entry(archive, "indptr", header(indptr.num_vals, indptr),
+              indptr.data, indptr.num_vals * indptr.word_size, compressed,
+              parameters);
+    add_entry(archive, "format",
+              create_npy_header({}, 'S', format_name.size()),
+              format_name.data(), format_name.size(), compressed, parameters);
+    add_entry(archive, "shape",
+              header(shape_values.size(), {nullptr, 0, 'i', sizeof(int64_t)}),
+              shape_values.data(), sizeof(shape_values), compressed,
+              parameters);
+    add_entry(archive, "data", header(data.num_vals, data), data.data,
+              data.num_vals * data.word_size, compressed, parameters);
+  } catch (...) {
+    zip_discard(archive);
+    throw;
+  }
+
+  if (zip_close(archive) != 0) {
+    std::string const message = zip_strerror(archive);
+    zip_discard(archive);
+    throw std::runtime_error("save_sparse_npz: " + message);
+  }
+}
+
+void cnpypp::save_sparse_npz(std::string const& fname,
+                             SparseMatrix const& matrix, bool compressed) {
+  auto const component = [](NpyArray const& array) {
+    if (!array.labels.empty()) {
+      throw std::runtime_error(
+          "save_sparse_npz: structured arrays not supported");
+    }
+    return detail::sparse_component{array.data<std::byte>(), array.num_vals,
+                                    array.data_types.at(0),
+                                    array.word_sizes.at(0)};
+  };
+
+  detail::save_sparse_npz(fname, matrix.format, matrix.shape,
+                          component(matrix.data), component(matrix.indices),
+                          component(matrix.indptr), compressed);
+}
+
+#endif
@@ -0,0 +1,474 @@
+// Copyright (C) 2023 Maximilian Reininghaus
+// Released under MIT License
+// license available in LICENSE file, or at
+// http://www.opensource.org/licenses/mit-license.php
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cnpy++.hpp"
+
+using namespace cnpypp;
+
+static size_t constexpr block_size = 32;              // edge length of tiles
+static size_t constexpr slab_bytes = 0x1000000;       // 16 MiB per slab
+static size_t constexpr min_parallel_bytes = 0x40000; // below: single thread
+
+// calls f(begin, end) on disjoint parts of [0, n) in parallel
+template <typename F>
+static void parallel_for(size_t n, unsigned num_threads, F const& f) {
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = static_cast<unsigned>(std::min<size_t>(num_threads, n));
+
+  if (num_threads <= 1) {
+    f(size_t{0}, n);
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  size_t const chunk = (n + num_threads - 1) / num_threads;
+
+  for (unsigned t = 1; t < num_threads; ++t) {
+    size_t const begin = std::min(n, t * chunk);
+    size_t const end = std::min(n, begin + chunk);
+    threads.emplace_back(f, begin, end);
+  }
+  f(size_t{0}, std::min(n, chunk));
+
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+// Copies the array of the given shape with element strides src_strides to
+// dst, which is filled contiguously in Fortran order (first axis fastest).
+// The copy is tiled over the first axis and the axis along which src is
+// densest. N is the element size in bytes if known at compile time, 0
+// otherwise.
+template <size_t N>
+static void copy_strided(std::byte const* src, std::byte* dst,
+                         std::vector<size_t> const& shape,
+                         std::vector<size_t> const& src_strides, size_t esize,
+                         unsigned num_threads) {
+  size_t const elem = N ? N : esize;
+  auto const copy = [elem](std::byte* d, std::byte const* s) {
+    std::memcpy(d, s, N ? N : elem);
+  };
+
+  size_t const rank = shape.size();
+  if (rank == 0) {
+    copy(dst, src);
+    return;
+  } else if (rank == 1) {
+    for (size_t i = 0; i < shape[0]; ++i) {
+      copy(dst + i * elem, src + i * src_strides[0] * elem);
+    }
+    return;
+  }
+
+  std::vector<size_t> dst_strides(rank);
+  std::exclusive_scan(shape.begin(), shape.end(), dst_strides.begin(),
+                      size_t{1}, std::multiplies<size_t>());
+
+  // second tiled axis: smallest source stride among the remaining ones
+  size_t tiled = rank - 1;
+  for (size_t k = 1; k < rank; ++k) {
+    if (shape[k] > 1 && src_strides[k] < src_strides[tiled]) {
+      tiled = k;
+    }
+  }
+
+  std::vector<size_t> middle; // all other axes
+  for (size_t k = 1; k < rank; ++k) {
+    if (k != tiled) {
+      middle.push_back(k);
+    }
+  }
+
+  size_t const first = shape.front(), second = shape[tiled];
+  size_t const num_middle =
+      std::accumulate(middle.begin(), middle.end(), size_t{1},
+                      [&shape](size_t p, size_t k) { return p * shape[k]; });
+  size_t const num_blocks = (second + block_size - 1) / block_size;
+
+  size_t const s_first = src_strides.front(), s_second = src_strides[tiled];
+  size_t const d_second = dst_strides[tiled];
+
+  // one task: block_size indices of the tiled axis for a fixed combination of
+  // the middle indices, all indices of the first axis
+  auto const work = [&](size_t task_begin, size_t task_end) {
+    for (size_t task = task_begin; task < task_end; ++task) {
+      size_t m = task / num_blocks;
+      size_t const j_begin = (task % num_blocks) * block_size;
+      size_t const j_end = std::min(second, j_begin + block_size);
+
+      size_t src_offset = 0, dst_offset = 0;
+      for (size_t const k : middle) {
+        size_t const i = m % shape[k];
+        m /= shape[k];
+        src_offset += i * src_strides[k];
+        dst_offset += i * dst_strides[k];
+      }
+
+      for (size_t i_begin = 0; i_begin < first; i_begin += block_size) {
+        size_t const i_end = std::min(first, i_begin + block_size);
+        for (size_t j = j_begin; j < j_end; ++j) {
+          std::byte const* s = src + (src_offset + j * s_second) * elem;
+          std::byte* d = dst + (dst_offset + j * d_second) * elem;
+          for (size_t i = i_begin; i < i_end; ++i) {
+            copy(d + i * elem, s + i * s_first * elem);
+          }
+        }
+      }
+    }
+  };
+
+  size_t const total_bytes = num_middle * first * second * elem;
+  parallel_for(num_middle * num_blocks,
+               (total_bytes < min_parallel_bytes) ? 1 : num_threads, work);
+}
+
+static void copy_strided(std::byte const* src, std::byte* dst,
+                         std::vector<size_t> const& shape,
+                         std::vector<size_t> const& src_strides, size_t esize,
+                         unsigned num_threads) {
+  switch (esize) {
+  case 1:
+    return copy_strided<1>(src, dst, shape, src_strides, esize, num_threads);
+  case 2:
+    return copy_strided<2>(src, dst, shape, src_strides, esize, num_threads);
+  case 4:
+    return copy_strided<4>(src, dst, shape, src_strides, esize, num_threads);
+  case 8:
+    return copy_strided<8>(src, dst, shape, src_strides, esize, num_threads);
+  case 16:
+    return copy_strided<16>(src, dst, shape, src_strides, esize, num_threads);
+  default:
+    return copy_strided<0>(src, dst, shape, src_strides, esize, num_threads);
+  }
+}
+
+// the shape under which data in memory order src_order are in C order
+static std::vector<size_t> c_order_shape(cnpypp::span<size_t const> shape,
+                                         MemoryOrder src_order) {
+  std::vector<size_t> shape_c{shape.begin(), shape.end()};
+  if (src_order == MemoryOrder::Fortran) {
+    std::reverse(shape_c.begin(), shape_c.end());
+  }
+  return shape_c;
+}
+
+static std::vector<size_t> c_order_strides(std::vector<size_t> const& shape) {
+  std::vector<size_t> strides(shape.size());
+  std::exclusive_scan(shape.rbegin(), shape.rend(), strides.rbegin(),
+                      size_t{1}, std::multiplies<size_t>());
+  return strides;
+}
+
+void cnpypp::transpose_memory_order(std::byte const* src, std::byte* dst,
+                                    cnpypp::span<size_t const> shape,
+                                    size_t element_size, MemoryOrder src_order,
+                                    unsigned num_threads) {
+  auto const shape_c = c_order_shape(shape, src_order);
+  copy_strided(src, dst, shape_c, c_order_strides(shape_c), element_size,
+               num_threads);
+}
+
+void cnpypp::write_data_transposed(std::byte const* src,
+                                   cnpypp::span<size_t const> shape,
+                                   size_t element_size, MemoryOrder src_order,
+                                   std::ostream& fs) {
+  auto shape_c = c_order_shape(shape, src_order);
+  auto const strides = c_order_strides(shape_c);
+
+  size_t const nels = std::accumulate(shape_c.begin(), shape_c.end(),
+                                      size_t{1}, std::multiplies<size_t>());
+  if (shape_c.size() < 2 || nels == 0) {
+    fs.write(reinterpret_cast<char const*>(src), nels * element_size);
+    return;
+  }
+
+  // The output is the Fortran-order layout of shape_c, in which the last
+  // axis varies slowest. Each slab is a range along that axis and is
+  // contiguous in the output.
+  size_t const last = shape_c.back();
+  size_t const row_bytes = nels / last * element_size;
+  size_t const rows_per_slab =
+      std::clamp<size_t>(slab_bytes / row_bytes, 1, last);
+
+  auto const buffer = std::make_unique<std::byte[]>(rows_per_slab * row_bytes);
+
+  for (size_t row = 0; row < last; row += rows_per_slab) {
+    size_t const rows = std::min(rows_per_slab, last - row);
+    shape_c.back() = rows;
+    copy_strided(src + row * strides.back() * element_size, buffer.get(),
+                 shape_c, strides, element_size, 0);
+    fs.write(reinterpret_cast<char const*>(buffer.get()), rows * row_bytes);
+  }
+}
+
+// advances the mixed-radix index idx with the given radices, returns false
+// after the last one
+static bool next_index(std::vector<size_t>& idx,
+                       std::vector<size_t> const& radices) {
+  for (size_t k = idx.size(); k-- > 0;) {
+    if (++idx[k] < radices[k]) {
+      return true;
+    }
+    idx[k] = 0;
+  }
+  return false;
+}
+
+// calls f(offset, length) for the contiguous runs, in elements, that make up
+// the box [lo, lo + extent) of a C-order array, in storage order
+template <typename F>
+static void for_each_run(std::vector<size_t> const& lo,
+                         std::vector<size_t> const& extent,
+                         std::vector<size_t> const& shape,
+                         std::vector<size_t> const& strides, F const& f) {
+  // the runs extend over the axes behind the last restricted one
+  size_t last = 0;
+  for (size_t k = 0; k < shape.size(); ++k) {
+    if (extent[k] != shape[k]) {
+      last = k;
+    }
+  }
+  size_t const run = std::accumulate(extent.begin() + last, extent.end(),
+                                     size_t{1}, std::multiplies<size_t>());
+
+  std::vector<size_t> idx(last, 0), radices(extent.begin(),
+                                            extent.begin() + last);
+  do {
+    size_t offset = lo[last] * strides[last];
+    for (size_t k = 0; k < last; ++k) {
+      offset += (lo[k] + idx[k]) * strides[k];
+    }
+    f(offset, run);
+  } while (next_index(idx, radices));
+}
+
+// Extents (per physical input axis) of the tiles in which npy_relayout()
+// copies the data, with at most max_elements elements. The input is read in
+// runs along its trailing axes and the output written in runs along its
+// trailing axes, perm[q] being the input axis of output axis q. About half
+// of the tile (sqrt(max_elements) elements, as for square tiles in 2D) is
+// spent on the runs of each side, the rest on further input axes.
+static std::vector<size_t> tile_extents(std::vector<size_t> const& shape,
+                                        std::vector<size_t> const& perm,
+                                        size_t max_elements) {
+  size_t const rank = shape.size();
+  size_t const target = std::max<size_t>(
+      static_cast<size_t>(std::sqrt(static_cast<double>(max_elements))), 1);
+  std::vector<size_t> extents(rank, 1);
+  size_t size = 1; // elements per tile
+
+  // grows axis k towards the given run length, without exceeding max_elements
+  auto const grow = [&](size_t k, size_t run_length, size_t run) {
+    size_t const e = std::clamp<size_t>(run_length / run, 1, shape[k]);
+    size_t const limit = max_elements / (size / extents[k]);
+    if (e > extents[k]) {
+      size = size / extents[k] * std::min(e, limit);
+      extents[k] = std::min(e, limit);
+    }
+    return extents[k] == shape[k]; // whether the run continues
+  };
+
+  for (size_t k = rank, run = 1; k-- > 0;) { // input runs
+    bool const full = grow(k, target, run);
+    run *= extents[k];
+    if (!full) {
+      break;
+    }
+  }
+  for (size_t q = rank, run = 1; q-- > 0;) { // output runs
+    bool const full = grow(perm[q], target, run);
+    run *= extents[perm[q]];
+    if (!full) {
+      break;
+    }
+  }
+  for (size_t k = rank; k-- > 0;) { // remaining budget
+    grow(k, max_elements, size / extents[k]);
+  }
+
+  return extents;
+}
+
+void cnpypp::npy_relayout(std::string const& in_fname,
+                          std::string const& out_fname,
+                          cnpypp::span<size_t const> axes,
+                          MemoryOrder out_order, size_t memory_budget) {
+  std::ifstream in{in_fname, std::ios::binary};
+  if (!in) {
+    throw std::runtime_error("npy_relayout: Unable to open file " + in_fname);
+  }
+
+  std::vector<size_t> word_sizes, shape;
+  std::vector<char> data_types;
+  std::vector<std::string> labels;
+  std::vector<std::vector<size_t>> field_shapes;
+  MemoryOrder in_order;
+  parse_npy_header(in, word_sizes, data_types, labels, field_shapes, shape,
+                   in_order);
+  std::streamoff const data_offset = in.tellg();
+
+  size_t const rank = shape.size();
+  size_t const esize = std::accumulate(word_sizes.begin(), word_sizes.end(),
+                                       size_t{0}, std::plus<size_t>());
+  size_t const nels = std::accumulate(shape.begin(), shape.end(), size_t{1},
+                                      std::multiplies<size_t>());
+
+  std::vector<size_t> permutation(rank);
+  if (axes.empty()) {
+    std::iota(permutation.begin(), permutation.end(), size_t{0});
+  } else if (axes.size() == rank) {
+    permutation.assign(axes.begin(), axes.end());
+  } else {
+    throw std::invalid_argument("npy_relayout: axes do not match rank");
+  }
+
+  std::vector<bool> seen(rank, false);
+  for (auto const a : permutation) {
+    if (a >= rank || seen[a]) {
+      throw std::invalid_argument("npy_relayout: axes are no permutation");
+    }
+    seen[a] = true;
+  }
+
+  // logical shape of the result
+  std::vector<size_t> out_shape(rank);
+  for (size_t k = 0; k < rank; ++k) {
+    out_shape[k] = shape[permutation[k]];
+  }
+
+  std::ofstream out{out_fname, std::ios::binary | std::ios::trunc};
+  if (!out) {
+    throw std::runtime_error("npy_relayout: Unable to open file " + out_fname);
+  }
+
+  std::vector<char> const header = std::invoke([&]() {
+    if (labels.empty()) {
+      return create_npy_header(out_shape, data_types.at(0),
+                               static_cast<int>(word_sizes.at(0)), out_order);
+    } else {
+      std::vector<std::string_view> const label_views{labels.begin(),
+                                                      labels.end()};
+      return create_npy_header(out_shape, label_views, data_types, word_sizes,
+                               field_shapes, out_order);
+    }
+  });
+  out.write(header.data(), header.size());
+
+  auto const check = [&]() {
+    if (!in) {
+      throw std::runtime_error("npy_relayout: reading " + in_fname +
+                               " failed");
+    } else if (!out) {
+      throw std::runtime_error("npy_relayout: writing " + out_fname +
+                               " failed");
+    }
+  };
+
+  if (rank < 2 || nels == 0) { // layout does not change
+    std::vector<char> buffer(
+        std::max<size_t>(std::min(nels * esize, memory_budget), 1));
+    for (size_t remaining = nels * esize; remaining > 0;) {
+      size_t const n = std::min(remaining, buffer.size());
+      in.read(buffer.data(), n);
+      out.write(buffer.data(), n);
+      check();
+      remaining -= n;
+    }
+    return;
+  }
+
+  // Work on the physical (C-order) views of input and output: physical
+  // output axis q corresponds to physical input axis perm[q].
+  auto const in_shape_c = c_order_shape(shape, in_order);
+  auto const out_shape_c = c_order_shape(out_shape, out_order);
+  auto const in_strides = c_order_strides(in_shape_c);
+  auto const out_strides = c_order_strides(out_shape_c);
+  auto const physical = [rank](size_t axis, MemoryOrder order) {
+    return (order == MemoryOrder::C) ? axis : rank - 1 - axis;
+  };
+  std::vector<size_t> perm(rank);
+  for (size_t q = 0; q < rank; ++q) {
+    perm[q] = physical(permutation[physical(q, out_order)], in_order);
+  }
+
+  // read and write buffer take at most half of the budget each
+  size_t const max_elements = std::max(memory_budget / 2, esize) / esize;
+  auto const extents = tile_extents(in_shape_c, perm, max_elements);
+  size_t const tile_size = std::accumulate(
+      extents.begin(), extents.end(), size_t{1}, std::multiplies<size_t>());
+  auto const read_buffer = std::make_unique<std::byte[]>(tile_size * esize);
+  auto const write_buffer = std::make_unique<std::byte[]>(tile_size * esize);
+
+  // The tiles are visited in output order, so that the file is written
+  // mostly front to back. Index tile[q] counts along physical output axis q.
+  std::vector<size_t> tile(rank, 0), num_tiles(rank);
+  for (size_t q = 0; q < rank; ++q) {
+    num_tiles[q] = (out_shape_c[q] + extents[perm[q]] - 1) / extents[perm[q]];
+  }
+
+  do {
+    // box within the input, per physical input axis
+    std::vector<size_t> lo(rank), extent(rank);
+    for (size_t q = 0; q < rank; ++q) {
+      size_t const k = perm[q];
+      lo[k] = tile[q] * extents[k];
+      extent[k] = std::min(extents[k], in_shape_c[k] - lo[k]);
+    }
+
+    std::byte* dst = read_buffer.get();
+    for_each_run(lo, extent, in_shape_c, in_strides,
+                 [&](size_t offset, size_t run) {
+                   in.seekg(data_offset +
+                            static_cast<std::streamoff>(offset * esize));
+                   in.read(reinterpret_cast<char*>(dst), run * esize);
+                   check();
+                   dst += run * esize;
+                 });
+
+    // permute in memory: the box in output C order is the Fortran order of
+    // the reversed output axes
+    auto const box_strides = c_order_strides(extent);
+    std::vector<size_t> shape_f(rank), strides_f(rank);
+    for (size_t k = 0; k < rank; ++k) {
+      shape_f[k] = extent[perm[rank - 1 - k]];
+      strides_f[k] = box_strides[perm[rank - 1 - k]];
+    }
+    copy_strided(read_buffer.get(), write_buffer.get(), shape_f, strides_f,
+                 esize, 0);
+
+    std::vector<size_t> out_lo(rank), out_extent(rank);
+    for (size_t q = 0; q < rank; ++q) {
+      out_lo[q] = lo[perm[q]];
+      out_extent[q] = extent[perm[q]];
+    }
+
+    std::byte const* src = write_buffer.get();
+    for_each_run(out_lo, out_extent, out_shape_c, out_strides,
+                 [&](size_t offset, size_t run) {
+                   out.seekp(static_cast<std::streamoff>(header.size() +
+                                                         offset * esize));
+                   out.write(reinterpret_cast<char const*>(src), run * esize);
+                   check();
+                   src += run * esize;
+                 });
+  } while (next_index(tile, num_tiles));
+}